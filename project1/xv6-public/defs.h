@@ -9,7 +9,9 @@ struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
-struct qLocation;
+struct mlfq;
+struct mlfqconf;
+struct schedevent;
 
 // bio.c
 void            binit(void);
@@ -80,6 +82,9 @@ extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
 void            lapicstartap(uchar, uint);
+uint            lapictimer(void);
+void            lapictimermask(int);
+void            lapicipi(int, int);
 void            microdelay(int);
 
 // log.c
@@ -124,23 +129,30 @@ void            yield(void);
 
 // mlfq scheduler in proc.c
 void			printProcess(const char* funcName, struct proc* targetProc);
-struct proc*    schedulerChooseProcess(int qLevel);
+struct proc*    schedulerChooseProcess(struct mlfq* rq, int qLevel);
 int             isValidProcess(struct proc* p);
-void            increaseExecTime(struct proc* p);
+int             boostTick(void);
 void            priorityBoosting(void);
 int             getLevel(void);
 void            setPriority(int pid, int priority);
 void            schedulerLock(int password);
 void			schedulerLockDone(int isExit);
 void            schedulerUnlock(int password);
+void            rtlaneRefill(void);
+int             rtlaneSetBudget(int ticks);
+int             setCpuShare(int pid, int percent);
+int             mlfqSetConfig(struct mlfqconf* c);
+void            mlfqGetConfig(struct mlfqconf* c);
+int             mlfqBoostPeriod(void);
 
 // queue handler in proc.c
 void            qinit(void);
-int             findFromQueueByPid(int pid, struct qLocation* qLoc);
+int             MLFQhighestLevel(struct mlfq* rq);
 int             MLFQenqueue(struct proc* p, int qLevel);
 int             MLFQfrontEnqueue(struct proc* p, int qLevel);
-int             MLFQdeleteByPid(int pid);
-struct proc*    MLFQdequeue(int qLevel);
+int             MLFQdelete(struct proc* p);
+struct proc*    MLFQfirstProc(struct mlfq* rq, int qLevel);
+struct proc*    MLFQdequeue(struct mlfq* rq, int qLevel);
 
 // swtch.S
 void            swtch(struct context**, struct context*);
@@ -154,6 +166,16 @@ void            release(struct spinlock*);
 void            pushcli(void);
 void            popcli(void);
 
+// timerwheel.c
+void            timerinit(void);
+void            timertick(void);
+int             timersleep(int);
+int             timernanosleep(int, int);
+
+// schedtrace.c
+void            tracesched(int, struct proc*);
+int             readschedtrace(struct schedevent*, int);
+
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
@@ -17,6 +17,7 @@
 #define EOI     (0x00B0/4)   // EOI
 #define SVR     (0x00F0/4)   // Spurious Interrupt Vector
   #define ENABLE     0x00000100   // Unit Enable
+#define IRR     (0x0200/4)   // Interrupt Request, 8 registers 0x10 apart
 #define ESR     (0x0280/4)   // Error Status
 #define ICRLO   (0x0300/4)   // Interrupt Command
   #define INIT       0x00000500   // INIT/RESET
@@ -66,7 +67,7 @@ lapicinit(void)
   // TICR would be calibrated using an external time source.
   lapicw(TDCR, X1);
   lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
-  lapicw(TICR, 10000000);
+  lapicw(TICR, TICKCYCLES);
 
   // Disable logical interrupt lines.
   lapicw(LINT0, MASKED);
@@ -113,6 +114,59 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// Has the timer of this cpu expired without its interrupt taken yet?
+static int
+timerpending(void)
+{
+  int vector = T_IRQ0 + IRQ_TIMER;
+
+  return (lapic[IRR + (vector / 32) * 4] >> (vector % 32)) & 1;
+}
+
+// Timer cycles elapsed in the current period of this cpu's timer.
+// A period which ran out before its interrupt was taken counts
+// as a whole, so the result is below 2*TICKCYCLES.
+uint
+lapictimer(void)
+{
+  int pending;
+  uint count;
+
+  if(!lapic)
+    return 0;
+  pending = timerpending();
+  count = lapic[TCCR];
+  if(!pending && timerpending()){
+    // expired between the two reads
+    pending = 1;
+    count = lapic[TCCR];
+  }
+  return (pending ? TICKCYCLES : 0) + TICKCYCLES - count;
+}
+
+// Stop (masked != 0) or restart the timer interrupts of this cpu.
+void
+lapictimermask(int masked)
+{
+  if(!lapic)
+    return;
+  lapicw(TIMER, (masked ? MASKED : 0) | PERIODIC | (T_IRQ0 + IRQ_TIMER));
+}
+
+// Send interrupt vector to the cpu with the given APIC ID.
+void
+lapicipi(int apicid, int vector)
+{
+  if(!lapic)
+    return;
+  pushcli(); // ICRHI and ICRLO are written as a pair
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+  popcli();
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
@@ -28,6 +28,7 @@ main(void)
   uartinit();      // serial port
   pinit();         // process table
   qinit();         // mlfQueue
+  timerinit();     // timer wheel for sleep
   tvinit();        // trap vectors
   binit();         // buffer cache
   fileinit();      // file table
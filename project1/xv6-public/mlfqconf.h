@@ -0,0 +1,11 @@
+// MLFQ parameters set at run time with mlfq_config,
+// shared by the kernel and mlfqctl.
+
+#define MAXQUANTUM   400  // max ticks of a time quantum or a boost period
+
+struct mlfqconf {
+  int nlevel;               // active levels, 2..MAXQLEVEL, the last one is
+                            // split by priority
+  int quantum[MAXQLEVEL];   // time quantum of each level in ticks
+  int boostperiod;          // ticks between priority boostings of a cpu
+};
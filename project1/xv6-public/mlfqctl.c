@@ -0,0 +1,61 @@
+// Show or set the MLFQ parameters of the running kernel.
+//
+// usage: mlfqctl [-l nlevel] [-q level ticks] [-b ticks]
+//   -l  number of active levels, the last one is split by priority
+//   -q  time quantum of a level
+//   -b  ticks between priority boostings
+// Without options the current parameters are printed.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "mlfqconf.h"
+
+void
+usage(void)
+{
+  printf(2, "usage: mlfqctl [-l nlevel] [-q level ticks] [-b ticks]\n");
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct mlfqconf conf;
+  int i, level;
+
+  if(mlfq_config(&conf, 0) < 0){
+    printf(2, "mlfqctl: mlfq_config failed\n");
+    exit();
+  }
+
+  for(i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-l") == 0 && i + 1 < argc){
+      conf.nlevel = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "-q") == 0 && i + 2 < argc){
+      level = atoi(argv[++i]);
+      if(level < 0 || level >= MAXQLEVEL){
+        printf(2, "mlfqctl: level %d out of 0..%d\n", level, MAXQLEVEL - 1);
+        exit();
+      }
+      conf.quantum[level] = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc){
+      conf.boostperiod = atoi(argv[++i]);
+    } else
+      usage();
+  }
+
+  if(argc > 1 && mlfq_config(&conf, 1) < 0){
+    printf(2, "mlfqctl: invalid parameters, levels 2..%d, ticks 1..%d\n",
+           MAXQLEVEL, MAXQUANTUM);
+    exit();
+  }
+
+  printf(1, "levels: %d\n", conf.nlevel);
+  for(i = 0; i < conf.nlevel; i++)
+    printf(1, "level %d quantum: %d ticks%s\n", i, conf.quantum[i],
+           i == conf.nlevel - 1 ? " (by priority)" : "");
+  printf(1, "boost period: %d ticks\n", conf.boostperiod);
+  exit();
+}
@@ -11,6 +11,14 @@
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       1000  // size of file system in blocks
-#define MAXQLEVEL    3  // max level of multi level queue
+#define MAXQLEVEL    8  // max levels of multi level queue, see mlfq_config
+#define NQLEVEL      3  // levels of multi level queue at boot
 #define MAXPRIORITY  4  // max priority of process
+#define BOOSTPERIOD  100  // ticks between priority boostings of a cpu at boot
+#define RTBUDGET     50   // ticks locked processes may run per boost period
+#define TICKCYCLES   10000000  // lapic timer cycles per tick
+#define TICKNS       10000000  // nominal nanoseconds per tick, divides TICKCYCLES
+#define MAXSTRIDESHARE 80  // percent of cpu time the stride class may reserve
+#define STRIDE1      10000  // stride of a 1 percent share
+#define PASSCYCLES   (TICKCYCLES / 1000)  // lapic timer cycles per pass step
 #define SLPASSWORD     2020028586
@@ -6,24 +6,65 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "traps.h"
+#include "schedtrace.h"
+#include "mlfqconf.h"
+
+#define SLEEPQBITS 6
+#define NSLEEPQ (1 << SLEEPQBITS) // sleep queues, sleepers hashed by chan
 
 struct
 {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct proc *sleepq[NSLEEPQ];
 } ptable;
 
+// Real-time lane: run queue of scheduler locked processes, served
+// before every MLFQ level of every cpu as long as the lane has budget
+// left in the current boost period.
 struct
 {
   struct spinlock lock;
-  struct proc *proc;
-} ltable;
-
+  struct mlfQueue queue; // RUNNABLE locked processes, round robin
+  uint budget;           // lapic timer cycles the lane may run per boost period
+  uint used;             // cycles run in this boost period, over all cpus
+} rtlane;
+
+// Stride scheduling class: processes given a share of cpu time with
+// set_cpu_share. The MLFQ class as a whole holds the rest of the cpu
+// and takes part in the stride selection with its own pass.
 struct
 {
   struct spinlock lock;
-  struct mlfQueue mlfQueue[MAXQLEVEL];
-} qtable;
+  struct proc *heap[NPROC]; // RUNNABLE stride processes, min-heap on pass
+  int n;                    // number of processes in heap
+  int totalShare;           // sum of the shares of all stride processes
+  uint mlfqPass;            // pass of the MLFQ class
+  uint mlfqStride;          // stride of the MLFQ class, from 100 - totalShare
+} strideq;
+
+// MLFQ run queues of a cpu, hung off struct cpu.
+// A process is linked into the run queues of the cpu it last ran on
+// (p->runq) while it is RUNNABLE and not running.
+struct mlfq
+{
+  struct spinlock lock;
+  struct mlfQueue mlfQueue[MAXQLEVEL - 1];   // levels above the last: round robin
+  struct mlfQueue bottomQueue[MAXPRIORITY];  // last level: one FIFO per priority
+  int nlevel;          // active levels, follows conf.nlevel
+  uint nonEmpty;       // bit qLevel is set iff that level has a process
+  uint bottomNonEmpty; // bit priority is set iff bottomQueue[priority] has a process
+  int count;           // number of processes in all levels
+  uint ticks;          // ticks of this cpu since its last priority boosting
+  struct cpu *cpu;     // cpu owning these run queues
+};
+
+static struct mlfq mlfqs[NCPU];
+
+// MLFQ parameters, see mlfq_config. Read without the lock.
+static struct spinlock conflock;
+static struct mlfqconf conf;
 
 static struct proc *initproc;
 
@@ -36,13 +77,28 @@ static void wakeup1(void *chan);
 void pinit(void)
 {
   initlock(&ptable.lock, "ptable");
-  initlock(&ltable.lock, "ltable");
+  initlock(&rtlane.lock, "rtlane");
+  rtlane.budget = RTBUDGET * TICKCYCLES;
+  initlock(&strideq.lock, "strideq");
+  strideq.mlfqStride = STRIDE1 / 100;
 }
 
 // init_queue function and call it in main() function to ensure queue is initialized before it is used in scheduler()
 void qinit(void)
 {
-  initlock(&qtable.lock, "qtable");
+  initlock(&conflock, "mlfqconf");
+  conf.nlevel = NQLEVEL;
+  for (int i = 0; i < MAXQLEVEL; i++)
+    conf.quantum[i] = TIME_QUANTUM(i);
+  conf.boostperiod = BOOSTPERIOD;
+
+  for (int i = 0; i < ncpu; i++)
+  {
+    initlock(&mlfqs[i].lock, "mlfq");
+    mlfqs[i].nlevel = conf.nlevel;
+    mlfqs[i].cpu = &cpus[i];
+    cpus[i].mlfq = &mlfqs[i];
+  }
 }
 
 // Must be called with interrupts disabled
@@ -72,6 +128,15 @@ mycpu(void)
   panic("unknown apicid\n");
 }
 
+// Lapic timer cycles this cpu has run. Wraps around, only differences
+// taken while the timer runs are meaningful.
+// Must be called with interrupts disabled.
+static uint
+cpucycles(void)
+{
+  return mycpu()->timerticks * TICKCYCLES + lapictimer();
+}
+
 // Disable interrupts so that we are not rescheduled
 // while reading proc from the cpu structure
 struct proc *
@@ -113,6 +178,9 @@ found:
   p->priority = MAXPRIORITY - 1;
   p->execTime = 0;
   p->isLock = UNLOCKED;
+  p->share = 0;
+  p->pass = 0;
+  p->heapIdx = 0;
 
   release(&ptable.lock);
 
@@ -147,231 +215,621 @@ void printProcess(const char *funcName, struct proc *targetProc)
   if (targetProc == 0)
     cprintf("\n[%s log] process is NULL!\n", funcName);
   else
-    cprintf("\n[%s log] pid: %d, qLevel: %d, state: %d, arrivedTime: %d, execTime: %d, priority: %d, isLock: %d\n", funcName, targetProc->pid, targetProc->qLevel, targetProc->state, targetProc->arrivedTime, targetProc->execTime, targetProc->priority, targetProc->isLock);
+    cprintf("\n[%s log] pid: %d, qLevel: %d, state: %d, arrivedTime: %d, execTime: %d, priority: %d, isLock: %d\n", funcName, targetProc->pid, targetProc->qLevel, targetProc->state, targetProc->arrivedTime, targetProc->execTime / TICKCYCLES, targetProc->priority, targetProc->isLock);
 }
 
-// enqueue in mlfQueue: ptable을 잡은 함수에서만 호출가능
-int MLFQenqueue(struct proc *p, int qLevel)
+// list of rq p belongs to when it is put in qLevel.
+// The last level is bucketed by priority, other levels have a single list.
+static struct mlfQueue *
+MLFQlistOf(struct mlfq *rq, struct proc *p, int qLevel)
 {
-  if (qLevel < 0 || qLevel >= MAXQLEVEL)
-    return -3; // invalid queue level input
-  else if (qtable.mlfQueue[qLevel].rear >= NPROC)
-    return -2; // queue already has more than max process number(NPROC)
-  else if (p != 0 && p->state != RUNNABLE)
-    return -1;
-
-  // enqueue logic starts here
-  acquire(&qtable.lock);
-
-  p->qLevel = qLevel;
-  qtable.mlfQueue[qLevel].procsQueue[qtable.mlfQueue[qLevel].rear] = p;
-  qtable.mlfQueue[qLevel].rear += 1;
-
-  release(&qtable.lock);
-  return 0;
+  if (qLevel < rq->nlevel - 1)
+    return &rq->mlfQueue[qLevel];
+  return &rq->bottomQueue[p->priority];
 }
 
-int MLFQfrontEnqueue(struct proc *p, int qLevel)
+// 1 if q is one of the priority lists of the last level of rq
+static int
+MLFQisBottom(struct mlfq *rq, struct mlfQueue *q)
 {
-  if (qLevel < 0 || qLevel >= MAXQLEVEL)
-    return -3; // invalid queue level input
-  else if (qtable.mlfQueue[qLevel].rear >= NPROC)
-    return -2; // queue already has more than max process number(NPROC)
-  else if (p != 0 && p->state != RUNNABLE)
-    return -1;
-
-  // enqueue logic starts here
-  acquire(&qtable.lock);
+  return q >= rq->bottomQueue && q < &rq->bottomQueue[MAXPRIORITY];
+}
 
-  for (int i = qtable.mlfQueue[qLevel].rear - 1; i > 0; i--)
+// push p at the tail of q, or at the head if front is set.
+// the lock protecting q must be held and p must not be in any list.
+static void
+listPush(struct mlfQueue *q, struct proc *p, int front)
+{
+  p->queue = q;
+  if (front)
+  {
+    p->qprev = 0;
+    p->qnext = q->head;
+    if (q->head != 0)
+      q->head->qprev = p;
+    else
+      q->tail = p;
+    q->head = p;
+  }
+  else
   {
-    qtable.mlfQueue[qLevel].procsQueue[i + 1] = qtable.mlfQueue[qLevel].procsQueue[i];
+    p->qnext = 0;
+    p->qprev = q->tail;
+    if (q->tail != 0)
+      q->tail->qnext = p;
+    else
+      q->head = p;
+    q->tail = p;
   }
+  q->count += 1;
+}
+
+// remove p from the list it is in. the lock protecting it must be held.
+static void
+listRemove(struct proc *p)
+{
+  struct mlfQueue *q = p->queue;
 
+  if (p->qprev != 0)
+    p->qprev->qnext = p->qnext;
+  else
+    q->head = p->qnext;
+  if (p->qnext != 0)
+    p->qnext->qprev = p->qprev;
+  else
+    q->tail = p->qprev;
+  p->qprev = 0;
+  p->qnext = 0;
+  p->queue = 0;
+  q->count -= 1;
+}
+
+// link p into the given level of rq, at the head if front is set.
+// A level below the last active one means the last one.
+// rq->lock must be held and p must not be in any level.
+static void
+MLFQlink(struct mlfq *rq, struct proc *p, int qLevel, int front)
+{
+  if (qLevel >= rq->nlevel)
+    qLevel = rq->nlevel - 1;
+  p->runq = rq;
   p->qLevel = qLevel;
+  listPush(MLFQlistOf(rq, p, qLevel), p, front);
+  rq->count += 1;
+  if (qLevel == rq->nlevel - 1)
+    rq->bottomNonEmpty |= 1 << p->priority;
+  rq->nonEmpty |= 1 << qLevel;
+}
 
-  qtable.mlfQueue[qLevel].procsQueue[0] = p;
-  qtable.mlfQueue[qLevel].rear += 1;
+// unlink p from the list it is in. p->runq->lock must be held.
+static void
+MLFQunlink(struct proc *p)
+{
+  struct mlfq *rq = p->runq;
+  struct mlfQueue *q = p->queue;
 
-  release(&qtable.lock);
-  return 0;
+  listRemove(p);
+  rq->count -= 1;
+  if (q->count != 0)
+    return;
+  if (MLFQisBottom(rq, q))
+  {
+    // p->priority may have changed since p was linked, use the list itself
+    rq->bottomNonEmpty &= ~(1 << (q - rq->bottomQueue));
+    if (rq->bottomNonEmpty == 0)
+      rq->nonEmpty &= ~(1 << p->qLevel);
+  }
+  else
+    rq->nonEmpty &= ~(1 << p->qLevel);
 }
 
-int findFromQueueByPid(int pid, struct qLocation *qLoc)
+// process to be scheduled next in qLevel of rq, null if the level is empty.
+// The last level gives the head of the FIFO of the highest(numerically
+// lowest) priority. rq->lock must be held.
+static struct proc *
+MLFQheadOf(struct mlfq *rq, int qLevel)
 {
-  struct proc *p = 0;
+  if (qLevel < rq->nlevel - 1)
+    return rq->mlfQueue[qLevel].head;
+  if (rq->bottomNonEmpty == 0)
+    return 0;
+  return rq->bottomQueue[bsf(rq->bottomNonEmpty)].head;
+}
 
-  // find process in mlfq table
-  int foundQLevel = -1;
-  int foundQIndex = -1;
-  int foundQRear = -1;
+// Wake a halted cpu for a process just put in rq: the owner of rq if it
+// is halted, otherwise another halted cpu to steal when rq holds more
+// than the one its owner runs next.
+static void
+MLFQkick(struct mlfq *rq)
+{
+  struct cpu *self, *c;
 
-  for (int qLevel = 0; qLevel < MAXQLEVEL; qLevel++)
+  pushcli();
+  self = mycpu();
+  if (rq->cpu->idle)
+  {
+    if (rq->cpu != self)
+      lapicipi(rq->cpu->apicid, T_IRQ0 + IRQ_WAKEUP);
+  }
+  else if (rq->count > 1)
   {
-    int qEntriesCnt = qtable.mlfQueue[qLevel].rear;
-    for (int qIndex = 0; qIndex < qEntriesCnt; qIndex++)
+    for (c = cpus; c < &cpus[ncpu]; c++)
     {
-      if (pid == qtable.mlfQueue[qLevel].procsQueue[qIndex]->pid)
+      if (c != self && c->idle)
       {
-        p = qtable.mlfQueue[qLevel].procsQueue[qIndex];
-        foundQLevel = qLevel;
-        foundQIndex = qIndex;
-        foundQRear = qEntriesCnt;
+        lapicipi(c->apicid, T_IRQ0 + IRQ_WAKEUP);
         break;
       }
     }
-    if (p != 0)
-      break;
   }
+  popcli();
+}
 
-  if (p == 0 || foundQIndex < 0 || foundQLevel < 0 || foundQRear < 0)
-    return -1;
-  else
+// Wake up to n halted cpus other than this one, to serve processes
+// put in a run queue every cpu takes from.
+static void
+wakeIdle(int n)
+{
+  struct cpu *self, *c;
+
+  pushcli();
+  self = mycpu();
+  for (c = cpus; c < &cpus[ncpu] && n > 0; c++)
   {
-    qLoc->qLevel = foundQLevel;
-    qLoc->qIndex = foundQIndex;
-    qLoc->qRear = foundQRear;
+    if (c != self && c->idle)
+    {
+      lapicipi(c->apicid, T_IRQ0 + IRQ_WAKEUP);
+      n--;
+    }
   }
-  return 0;
+  popcli();
 }
 
-int MLFQdeleteByPid(int pid)
+// Link a locked process into the real-time lane and wake a halted cpu
+// to serve it if the lane has budget left.
+static void
+rtlaneLink(struct proc *p, int front)
 {
-  struct qLocation qLoc = {0, 0, 0};
-  if (findFromQueueByPid(pid, &qLoc) == -1)
-    return -1;
+  int runnable;
+
+  acquire(&rtlane.lock);
+  if (p->queue != 0)
+    listRemove(p);
+  p->qLevel = TOP;
+  listPush(&rtlane.queue, p, front);
+  tracesched(EV_ENQUEUE, p);
+  runnable = rtlane.used < rtlane.budget;
+  release(&rtlane.lock);
+
+  if (runnable)
+    wakeIdle(1);
+}
 
-  int foundQLevel = qLoc.qLevel;
-  int foundQIndex = qLoc.qIndex;
-  int foundQRear = qLoc.qRear;
+// 1 if the scheduler would pick a process from the real-time lane
+static int
+rtlaneReady(void)
+{
+  return rtlane.queue.count != 0 && rtlane.used < rtlane.budget;
+}
 
-  acquire(&qtable.lock);
+// Take the next process of the real-time lane, null if the lane is
+// empty or its budget of this boost period is spent.
+static struct proc *
+rtlanePick(void)
+{
+  struct proc *p = 0;
 
-  // delete process from mlfq table
-  for (int qIter = foundQIndex; qIter < foundQRear - 1; qIter++)
+  acquire(&rtlane.lock);
+  if (rtlane.used < rtlane.budget && (p = rtlane.queue.head) != 0)
   {
-    qtable.mlfQueue[foundQLevel].procsQueue[qIter] = qtable.mlfQueue[foundQLevel].procsQueue[qIter + 1];
+    listRemove(p);
+    tracesched(EV_DEQUEUE, p);
   }
-  qtable.mlfQueue[foundQLevel].procsQueue[qtable.mlfQueue[foundQLevel].rear - 1] = 0;
+  release(&rtlane.lock);
+  return p;
+}
+
+// Start a new boost period of the real-time lane.
+// Called on cpu 0 every boost period.
+void rtlaneRefill(void)
+{
+  int n;
 
-  qtable.mlfQueue[foundQLevel].rear -= 1;
+  acquire(&rtlane.lock);
+  rtlane.used = 0;
+  n = rtlane.queue.count;
+  release(&rtlane.lock);
 
-  release(&qtable.lock);
+  // cpus halted on a spent budget sleep until woken
+  wakeIdle(n);
+}
 
+// Set the real-time lane budget to ticks of cpu time per boost period.
+int rtlaneSetBudget(int ticks)
+{
+  if (ticks < 0 || ticks > conf.boostperiod)
+    return -1;
+  acquire(&rtlane.lock);
+  rtlane.budget = ticks * TICKCYCLES;
+  release(&rtlane.lock);
   return 0;
 }
 
-struct proc *MLFQfirstProc(int qLevel)
+// Passes wrap around, compare them by difference.
+static int
+passBefore(uint a, uint b)
 {
-  if (qLevel < 0 || qLevel >= MAXQLEVEL)
-    return 0; // invalid queue level input, return null
-  else if (qtable.mlfQueue[qLevel].rear == 0)
-    return 0; // queue does not have any process, return null
+  return (int)(a - b) < 0;
+}
 
-  struct proc *p = 0;
-  if (qLevel < MAXQLEVEL - 1)
+// strideq.lock must be held for all heap functions.
+static void
+heapSet(int i, struct proc *p)
+{
+  strideq.heap[i] = p;
+  p->heapIdx = i + 1;
+}
+
+static void
+heapUp(int i)
+{
+  struct proc *p = strideq.heap[i];
+
+  while (i > 0 && passBefore(p->pass, strideq.heap[(i - 1) / 2]->pass))
   {
-    p = qtable.mlfQueue[qLevel].procsQueue[0];
+    heapSet(i, strideq.heap[(i - 1) / 2]);
+    i = (i - 1) / 2;
   }
-  else
+  heapSet(i, p);
+}
+
+static void
+heapDown(int i)
+{
+  struct proc *p = strideq.heap[i];
+  int child;
+
+  while ((child = 2 * i + 1) < strideq.n)
   {
-    int dequeueIndex = -1;
-    int minArrivedTime = 0;
+    if (child + 1 < strideq.n && passBefore(strideq.heap[child + 1]->pass, strideq.heap[child]->pass))
+      child++;
+    if (!passBefore(strideq.heap[child]->pass, p->pass))
+      break;
+    heapSet(i, strideq.heap[child]);
+    i = child;
+  }
+  heapSet(i, p);
+}
+
+static void
+heapRemove(struct proc *p)
+{
+  int i = p->heapIdx - 1;
+  struct proc *last = strideq.heap[--strideq.n];
+
+  p->heapIdx = 0;
+  if (last == p)
+    return;
+  heapSet(i, last);
+  heapUp(i);
+  heapDown(last->heapIdx - 1);
+}
+
+// Lowest pass of the stride class, including the MLFQ class.
+// A process joining or waking up starts from here, so it gets no
+// credit for the time it was not runnable.
+static uint
+strideNow(void)
+{
+  if (strideq.n != 0 && passBefore(strideq.heap[0]->pass, strideq.mlfqPass))
+    return strideq.heap[0]->pass;
+  return strideq.mlfqPass;
+}
+
+static void
+strideLink(struct proc *p)
+{
+  uint now;
+
+  acquire(&strideq.lock);
+  if (p->heapIdx == 0)
+  {
+    now = strideNow();
+    if (passBefore(p->pass, now))
+      p->pass = now;
+    heapSet(strideq.n++, p);
+    heapUp(strideq.n - 1);
+    tracesched(EV_ENQUEUE, p);
+  }
+  release(&strideq.lock);
+  wakeIdle(1);
+}
+
+// 1 if no cpu has a process in its MLFQ run queues
+static int
+mlfqEmpty(void)
+{
+  for (int i = 0; i < ncpu; i++)
+    if (mlfqs[i].count != 0)
+      return 0;
+  return 1;
+}
+
+// Take the stride process with the lowest pass. When the MLFQ class
+// has a process to run on this cpu, it runs instead if its pass is lower.
+static struct proc *
+stridePick(struct cpu *c)
+{
+  struct proc *p = 0;
 
-    for (int iterPrior = 0; iterPrior < MAXPRIORITY && dequeueIndex == -1; iterPrior++)
+  acquire(&strideq.lock);
+  if (strideq.n != 0)
+  {
+    p = strideq.heap[0];
+    if (c->mlfq->count != 0 && passBefore(strideq.mlfqPass, p->pass))
+      p = 0;
+    else
     {
-      minArrivedTime = qtable.mlfQueue[BOTTOM].procsQueue[0]->arrivedTime;
-      for (int i = 0; i < qtable.mlfQueue[BOTTOM].rear; i++)
-      {
-        // 1. priority가 높은 것 우선
-        // 2. FCFS: arrivedTime이 짧은 것 우선
-        if (qtable.mlfQueue[BOTTOM].procsQueue[i]->priority == iterPrior && qtable.mlfQueue[BOTTOM].procsQueue[i]->arrivedTime < minArrivedTime)
-        {
-          dequeueIndex = i;
-          break;
-        };
-      }
-      if (minArrivedTime == qtable.mlfQueue[BOTTOM].procsQueue[0]->arrivedTime)
-        dequeueIndex = 0;
+      // an MLFQ class with nothing to run on any cpu earns no credit
+      if (passBefore(strideq.mlfqPass, p->pass) && mlfqEmpty())
+        strideq.mlfqPass = p->pass;
+      heapRemove(p);
+      tracesched(EV_DEQUEUE, p);
     }
-
-    p = qtable.mlfQueue[BOTTOM].procsQueue[dequeueIndex];
   }
+  release(&strideq.lock);
   return p;
 }
 
-struct proc *MLFQdequeue(int qLevel)
+// Advance the pass of the class p ran in by the cycles it ran.
+static void
+strideCharge(struct proc *p, uint cycles)
 {
-  if (qLevel < 0 || qLevel >= MAXQLEVEL)
-    return 0; // invalid queue level input, return null
-  else if (qtable.mlfQueue[qLevel].rear == 0)
-    return 0; // queue does not have any process, return null
+  uint steps = cycles / PASSCYCLES;
 
-  // dequeue logic starts here
+  // passes only matter while some process has a share
+  if (strideq.totalShare == 0)
+    return;
+  acquire(&strideq.lock);
+  if (p->share != 0)
+    p->pass += (STRIDE1 / p->share) * steps;
+  else
+    strideq.mlfqPass += strideq.mlfqStride * steps;
+  release(&strideq.lock);
+}
 
-  struct proc *p = 0;
+// Move process pid into the stride class with percent of the cpu time,
+// or back to the MLFQ if percent is 0. The MLFQ class keeps at least
+// 100 - MAXSTRIDESHARE percent.
+int setCpuShare(int pid, int percent)
+{
+  struct proc *p;
+  int linked;
+
+  if (percent < 0 || percent > MAXSTRIDESHARE)
+    return -1;
 
-  if (qLevel < MAXQLEVEL - 1)
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if (p->pid == pid && p->state != UNUSED && p->state != ZOMBIE)
+      break;
+  if (p == &ptable.proc[NPROC])
   {
-    acquire(&qtable.lock);
+    release(&ptable.lock);
+    return -1;
+  }
 
-    p = qtable.mlfQueue[qLevel].procsQueue[0];
+  acquire(&strideq.lock);
+  if (strideq.totalShare - p->share + percent > MAXSTRIDESHARE)
+  {
+    release(&strideq.lock);
+    release(&ptable.lock);
+    return -1;
+  }
+  strideq.totalShare += percent - p->share;
+  strideq.mlfqStride = STRIDE1 / (100 - strideq.totalShare);
+  if (p->share == 0)
+    p->pass = strideNow();
+  release(&strideq.lock);
+
+  // relink a waiting process into the run queue of its new class
+  linked = MLFQdelete(p) == 0;
+  p->share = percent;
+  if (linked)
+    MLFQenqueue(p, p->qLevel);
 
-    // shift queue contents left to prevent overflow
-    for (int i = 0; i < qtable.mlfQueue[qLevel].rear - 1; i++)
-    {
-      qtable.mlfQueue[qLevel].procsQueue[i] = qtable.mlfQueue[qLevel].procsQueue[i + 1];
-    }
-    qtable.mlfQueue[qLevel].procsQueue[qtable.mlfQueue[qLevel].rear - 1] = 0;
-    qtable.mlfQueue[qLevel].rear -= 1; // dequeue and shift is over, decrease rear
+  release(&ptable.lock);
+  return 0;
+}
+
+// enqueue in mlfQueue: ptable을 잡은 함수에서만 호출가능
+// p goes to the run queues of the cpu it last ran on,
+// process already in a queue is moved to the rear of qLevel
+int MLFQenqueue(struct proc *p, int qLevel)
+{
+  if (qLevel < 0 || qLevel >= MAXQLEVEL)
+    return -3; // invalid queue level input
+  else if (p != 0 && p->state != RUNNABLE)
+    return -1;
 
-    release(&qtable.lock);
+  // locked processes are served by the real-time lane, processes with
+  // a cpu share by the stride class instead
+  if (p->isLock == LOCKED)
+  {
+    rtlaneLink(p, 0);
+    return 0;
   }
-  else
+  if (p->share != 0)
   {
-    // qLevel = BOTTOM, priority scheduling
-    acquire(&qtable.lock);
+    strideLink(p);
+    return 0;
+  }
 
-    int dequeueIndex = -1;
-    int minArrivedTime = 0;
+  // enqueue logic starts here
+  struct mlfq *rq = p->runq;
+  acquire(&rq->lock);
 
-    for (int iterPrior = 0; iterPrior < MAXPRIORITY && dequeueIndex == -1; iterPrior++)
-    {
-      minArrivedTime = qtable.mlfQueue[BOTTOM].procsQueue[0]->arrivedTime;
-      for (int i = 0; i < qtable.mlfQueue[BOTTOM].rear; i++)
-      {
-        if (qtable.mlfQueue[BOTTOM].procsQueue[i]->priority == iterPrior && qtable.mlfQueue[BOTTOM].procsQueue[i]->arrivedTime < minArrivedTime)
-        {
-          dequeueIndex = i;
-          break;
-        };
-      }
-      if (minArrivedTime == qtable.mlfQueue[BOTTOM].procsQueue[0]->arrivedTime)
-        dequeueIndex = 0;
-    }
+  if (p->queue != 0)
+    MLFQunlink(p);
+  MLFQlink(rq, p, qLevel, 0);
+  tracesched(EV_ENQUEUE, p);
 
-    p = qtable.mlfQueue[BOTTOM].procsQueue[dequeueIndex];
+  release(&rq->lock);
+  MLFQkick(rq);
+  return 0;
+}
 
-    // shift queue contents left to prevent overflow
-    for (int i = dequeueIndex; i < qtable.mlfQueue[BOTTOM].rear - 1; i++)
-    {
-      qtable.mlfQueue[BOTTOM].procsQueue[i] = qtable.mlfQueue[BOTTOM].procsQueue[i + 1];
-    }
-    qtable.mlfQueue[BOTTOM].procsQueue[qtable.mlfQueue[BOTTOM].rear - 1] = 0;
+int MLFQfrontEnqueue(struct proc *p, int qLevel)
+{
+  if (qLevel < 0 || qLevel >= MAXQLEVEL)
+    return -3; // invalid queue level input
+  else if (p != 0 && p->state != RUNNABLE)
+    return -1;
+
+  // locked processes are served by the real-time lane, processes with
+  // a cpu share by the stride class instead
+  if (p->isLock == LOCKED)
+  {
+    rtlaneLink(p, 1);
+    return 0;
+  }
+  if (p->share != 0)
+  {
+    strideLink(p);
+    return 0;
+  }
 
-    qtable.mlfQueue[BOTTOM].rear -= 1;
+  // enqueue logic starts here
+  struct mlfq *rq = p->runq;
+  acquire(&rq->lock);
+
+  if (p->queue != 0)
+    MLFQunlink(p);
+  MLFQlink(rq, p, qLevel, 1);
+  tracesched(EV_ENQUEUE, p);
+
+  release(&rq->lock);
+  MLFQkick(rq);
+  return 0;
+}
+
+// remove p from whichever level of mlfQueue it is in
+int MLFQdelete(struct proc *p)
+{
+  struct mlfq *rq = p->runq;
+
+  int linked;
+
+  if (p->isLock == LOCKED)
+  {
+    acquire(&rtlane.lock);
+    linked = p->queue != 0;
+    if (linked)
+      listRemove(p);
+    release(&rtlane.lock);
+    return linked ? 0 : -1;
+  }
+  if (p->share != 0)
+  {
+    acquire(&strideq.lock);
+    linked = p->heapIdx != 0;
+    if (linked)
+      heapRemove(p);
+    release(&strideq.lock);
+    return linked ? 0 : -1;
+  }
+  if (rq == 0)
+    return -1;
+  acquire(&rq->lock);
 
-    release(&qtable.lock);
+  if (p->queue == 0)
+  {
+    release(&rq->lock);
+    return -1;
   }
+  MLFQunlink(p);
+
+  release(&rq->lock);
+  return 0;
+}
+
+// highest(numerically lowest) level of rq which has a process, -1 if all empty
+int MLFQhighestLevel(struct mlfq *rq)
+{
+  uint nonEmpty = rq->nonEmpty;
+
+  if (nonEmpty == 0)
+    return -1;
+  return bsf(nonEmpty);
+}
+
+struct proc *MLFQfirstProc(struct mlfq *rq, int qLevel)
+{
+  if (qLevel < 0 || qLevel >= MAXQLEVEL)
+    return 0; // invalid queue level input, return null
+
+  struct proc *p = 0;
+
+  acquire(&rq->lock);
+  p = MLFQheadOf(rq, qLevel); // null if queue does not have any process
+  release(&rq->lock);
 
   return p;
 }
 
-void increaseExecTime(struct proc *p)
+struct proc *MLFQdequeue(struct mlfq *rq, int qLevel)
 {
-  acquire(&ptable.lock);
-  p->execTime = p->execTime + 1;
-  release(&ptable.lock);
+  if (qLevel < 0 || qLevel >= MAXQLEVEL)
+    return 0; // invalid queue level input, return null
+
+  // dequeue logic starts here
+
+  struct proc *p = 0;
+
+  acquire(&rq->lock);
+  p = MLFQheadOf(rq, qLevel);
+  if (p != 0)
+    MLFQunlink(p);
+  release(&rq->lock);
+
+  return p;
+}
+
+// Move a process from the lowest non-empty level of the busiest other
+// cpu into c's run queues. Only called by an idle cpu.
+// Return 1 if a process was stolen.
+static int
+MLFQsteal(struct cpu *c)
+{
+  struct mlfq *victim = 0;
+  struct proc *p = 0;
+  int most = 0;
+
+  // counts are read without locks, they only pick a victim
+  for (struct cpu *other = cpus; other < &cpus[ncpu]; other++)
+  {
+    if (other == c || other->mlfq->count <= most)
+      continue;
+    victim = other->mlfq;
+    most = victim->count;
+  }
+  if (victim == 0)
+    return 0;
+
+  acquire(&victim->lock);
+  for (int qLevel = victim->nlevel - 1; qLevel >= 0 && p == 0; qLevel--)
+    p = MLFQheadOf(victim, qLevel);
+  if (p != 0)
+    MLFQunlink(p);
+  release(&victim->lock);
+
+  if (p == 0)
+    return 0;
+
+  // locks of two run queues are never held together
+  p->runq = c->mlfq;
+  MLFQenqueue(p, p->qLevel);
+  return 1;
 }
 
 // PAGEBREAK: 32
@@ -407,6 +865,7 @@ void userinit(void)
   acquire(&ptable.lock);
 
   p->state = RUNNABLE;
+  p->runq = mycpu()->mlfq;
   MLFQenqueue(p, TOP);
 
   release(&ptable.lock);
@@ -482,6 +941,7 @@ int fork(void)
   np->qLevel = TOP;
   np->priority = MAXPRIORITY - 1;
   np->isLock = UNLOCKED;
+  np->runq = mycpu()->mlfq; // 부모가 실행중인 cpu에서 시작
 
   MLFQenqueue(np, TOP);
 
@@ -507,6 +967,9 @@ void exit(void)
   {
     schedulerLockDone(1);
   }
+  // give the cpu share back to the MLFQ class
+  if (curproc->share != 0)
+    setCpuShare(curproc->pid, 0);
 
   // Close all open files.
   for (fd = 0; fd < NOFILE; fd++)
@@ -522,7 +985,7 @@ void exit(void)
   iput(curproc->cwd);
   end_op();
   curproc->cwd = 0;
-  MLFQdeleteByPid(curproc->pid);
+  MLFQdelete(curproc);
 
   acquire(&ptable.lock);
 
@@ -593,16 +1056,18 @@ int wait(void)
   }
 }
 
-struct proc *schedulerChooseProcess(int qLevel)
+// Choose the process to run in qLevel of rq, demoting processes which
+// used up their time quantum on the way. rq->lock must be held.
+struct proc *schedulerChooseProcess(struct mlfq *rq, int qLevel)
 {
-  struct proc *targetProc = MLFQfirstProc(qLevel);
-  // TODO: dequeue by priority when qLevel is BOTTOM
+  struct proc *targetProc = MLFQheadOf(rq, qLevel);
 
   while (targetProc != 0)
   {
-    if (targetProc->state != RUNNABLE || targetProc->killed == 1)
+    if (targetProc->state != RUNNABLE)
     {
-      // deprecated process(state is not RUNNABLE or killed process) is kicked out of the queue
+      // deprecated process(state is not RUNNABLE) is kicked out of the queue
+      // killed process stays, it has to run once more to exit() in trap()
 
       // before kick out, init some process variables related to queue
       targetProc->execTime = 0;
@@ -610,29 +1075,30 @@ struct proc *schedulerChooseProcess(int qLevel)
 
       // TODO: enqueue initialized proc?
       //  No, 만약 enqueue하게 되면 RUNNABLE 하지 않은 프로세스들로 ptable이 가득 찬 경우 무한 루프를 돌게됨
-      //  RUNNABLE 하지 않거나 killed된 process들은 재실행시 다시 enqueue 하도록...
-      MLFQdequeue(qLevel);
-      targetProc = MLFQfirstProc(qLevel);
+      //  RUNNABLE 하지 않은 process들은 재실행시 다시 enqueue 하도록...
+      MLFQunlink(targetProc);
+      targetProc = MLFQheadOf(rq, qLevel);
       continue;
     }
 
     // only RUNNABLE process arrives in this conditional statement
-    if (targetProc->execTime >= TIME_QUANTUM(qLevel))
+    if (targetProc->execTime >= conf.quantum[qLevel] * TICKCYCLES)
     {
-      targetProc = MLFQdequeue(qLevel);
+      tracesched(EV_DEMOTE, targetProc);
+      MLFQunlink(targetProc);
       targetProc->execTime = 0;
-      if (qLevel < BOTTOM)
+      if (qLevel < rq->nlevel - 1)
       {
-        // qLevel = TOP, qLevel = MIDDLE
-        MLFQenqueue(targetProc, qLevel + 1);
+        // levels above the last one
+        MLFQlink(rq, targetProc, qLevel + 1, 0);
       }
       else
       {
         if (targetProc->priority > 0)
           targetProc->priority -= 1;
-        MLFQenqueue(targetProc, qLevel);
+        MLFQlink(rq, targetProc, qLevel, 0);
       }
-      targetProc = MLFQfirstProc(qLevel);
+      targetProc = MLFQheadOf(rq, qLevel);
       continue;
     }
 
@@ -654,6 +1120,56 @@ int isValidProcess(struct proc *p)
   return 0;
 }
 
+// Take the process to run next out of rq, null if rq is empty.
+// A running process is not in any run queue; yield() puts it back.
+static struct proc *
+MLFQpick(struct mlfq *rq)
+{
+  struct proc *p = 0;
+  int qLevel;
+
+  acquire(&rq->lock);
+  while ((qLevel = MLFQhighestLevel(rq)) >= 0)
+  {
+    // level emptied by kicking out or demoting its processes is
+    // cleared from the bitmap, so the next lower level is tried
+    p = schedulerChooseProcess(rq, qLevel);
+    if (isValidProcess(p))
+      break;
+  }
+  if (p != 0)
+  {
+    MLFQunlink(p);
+    tracesched(EV_DEQUEUE, p);
+  }
+  release(&rq->lock);
+
+  return p;
+}
+
+// Nothing to run on c: halt it until an interrupt or a wakeup IPI
+// (see MLFQkick) instead of spinning. The timer of a cpu other than
+// cpu 0, which keeps ticks, is stopped meanwhile.
+static void
+idle(struct cpu *c)
+{
+  cli();
+  // xchg orders the store of idle before reading the run queue,
+  // pairing with MLFQkick which reads idle after linking a process
+  xchg(&c->idle, 1);
+  if (c->mlfq->count == 0 && !rtlaneReady() && strideq.n == 0)
+  {
+    if (c != &cpus[0])
+      lapictimermask(1);
+    stihlt();
+    cli();
+    if (c != &cpus[0])
+      lapictimermask(0);
+  }
+  xchg(&c->idle, 0);
+  sti();
+}
+
 // PAGEBREAK: 42
 //  Per-CPU process scheduler.
 //  Each CPU calls scheduler() after setting itself up.
@@ -673,106 +1189,67 @@ void scheduler(void)
     sti();
     struct proc *targetProc = 0;
 
-    acquire(&ltable.lock);
-	targetProc = ltable.proc;
-    release(&ltable.lock);
-
-    if (targetProc != 0)
+    // The real-time lane goes first while it has budget. Then the stride
+    // class and the MLFQ class take turns by pass. For the MLFQ, pick a
+    // process from the highest non-empty level of this cpu's mlfQueue,
+    // steal one from the busiest other cpu if there is none.
+    // Only the state change and swtch need ptable.lock.
+    targetProc = rtlanePick();
+    if (targetProc == 0)
+      targetProc = stridePick(c);
+    if (targetProc == 0)
+      targetProc = MLFQpick(c->mlfq);
+    if (targetProc == 0 && MLFQsteal(c))
+      targetProc = MLFQpick(c->mlfq);
+    if (targetProc == 0)
     {
-      if (targetProc->state != RUNNABLE || targetProc->killed == 1)
-      {
-        schedulerLockDone(0);
-        continue;
-      }
-      
-	  // locked process exists
-      c->proc = targetProc;
-      switchuvm(targetProc);
-
-      acquire(&ptable.lock);
-      targetProc->state = RUNNING;
-
-      swtch(&(c->scheduler), targetProc->context);
-      switchkvm();
-
-      // Process is done running for now.
-      // It should have changed its p->state before coming back.
-      c->proc = 0;
-      release(&ptable.lock);
-    }
-    // Loop over process table looking for process to run.
-    else
-    {
-      acquire(&ptable.lock);
-
-      for (int qLevel = 0; qLevel < MAXQLEVEL; qLevel++)
-      {
-        targetProc = 0;
-
-        // TODO: check for higher level queue has new arrived RUNNABLE process
-        for (int prev = 0; prev <= qLevel; prev++)
-        {
-          targetProc = schedulerChooseProcess(prev);
-
-          if (isValidProcess(targetProc))
-          {
-            qLevel = prev;
-            break;
-          }
-        }
-
-        if (!isValidProcess(targetProc) || targetProc->execTime >= TIME_QUANTUM(qLevel))
-          continue;
-
-        // Switch to chosen process.  It is the process's job
-        // to release ptable.lock and then reacquire it
-        // before jumping back to us.
-        c->proc = targetProc;
-        switchuvm(targetProc);
-        targetProc->state = RUNNING;
-
-        swtch(&(c->scheduler), targetProc->context);
-        switchkvm();
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-      }
-
-      release(&ptable.lock);
+      idle(c);
+      continue;
     }
 
-	/*
-    if (targetProc == 0 && ltable.proc == 0)
-    {
-      // Missing process to run
-      // Find RUNNABLE process in ptable
-      acquire(&ptable.lock);
+    acquire(&ptable.lock);
 
-      for (struct proc *p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-      {
-        if (p->state != RUNNABLE || p->killed == 1)
-          continue;
+    // Switch to chosen process.  It is the process's job
+    // to release ptable.lock and then reacquire it
+    // before jumping back to us.
+    c->proc = targetProc;
+    switchuvm(targetProc);
+    targetProc->state = RUNNING;
+    targetProc->sliceStart = cpucycles();
 
-        // check for same process is already in MLFQ
-        struct qLocation qLoc = {0, 0, 0};
-        if (findFromQueueByPid(p->pid, &qLoc) == 0)
-          continue;
+    swtch(&(c->scheduler), targetProc->context);
+    switchkvm();
 
-        c->proc = p;
-        switchuvm(p);
-        p->state = RUNNING;
+    // Process is done running for now.
+    // It should have changed its p->state before coming back.
+    c->proc = 0;
 
-        swtch(&(c->scheduler), p->context);
-        switchkvm();
+    release(&ptable.lock);
+  }
+}
 
-        c->proc = 0;
-        break;
-      }
+// Charge the cycles p ran since sliceStart to the time quantum and
+// the pass of its class, or to the budget of the real-time lane for
+// a locked process, and start a new slice. Called before p changes
+// class so each class pays for its own part of the slice.
+static void
+chargeSlice(struct proc *p)
+{
+  uint now, slice;
 
-      release(&ptable.lock);
-    }
-	*/
+  now = cpucycles();
+  slice = now - p->sliceStart;
+  p->sliceStart = now;
+  if (p->isLock == LOCKED)
+  {
+    acquire(&rtlane.lock);
+    rtlane.used += slice;
+    release(&rtlane.lock);
+  }
+  else
+  {
+    p->execTime += slice;
+    strideCharge(p, slice);
   }
 }
 
@@ -796,6 +1273,8 @@ void sched(void)
     panic("sched running");
   if (readeflags() & FL_IF)
     panic("sched interruptible");
+  chargeSlice(p);
+  tracesched(EV_SWITCH, p);
   intena = mycpu()->intena;
   swtch(&p->context, mycpu()->scheduler);
   mycpu()->intena = intena;
@@ -811,11 +1290,7 @@ void yield(void)
   acquire(&ptable.lock);      // DOC: yieldlock
   myproc()->state = RUNNABLE; // 실행되던 프로세스를 다시 RUNNING에서 RUNNABLE로 바꿔줌
 
-  if (myproc()->isLock == UNLOCKED)
-  {
-    MLFQdequeue(myproc()->qLevel);
-    MLFQenqueue(myproc(), myproc()->qLevel);
-  }
+  MLFQenqueue(myproc(), myproc()->qLevel); // 같은 level(lock된 경우 real-time lane)의 맨 뒤로 이동
   sched();
   release(&ptable.lock);
 }
@@ -841,6 +1316,42 @@ void forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// Sleep queue of the processes sleeping on chan.
+static uint
+sleephash(void *chan)
+{
+  return ((uint)chan * 2654435761U) >> (32 - SLEEPQBITS);
+}
+
+// Link p, which is going to sleep on p->chan, into its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqadd(struct proc *p)
+{
+  struct proc **pp = &ptable.sleepq[sleephash(p->chan)];
+
+  p->snext = *pp;
+  *pp = p;
+}
+
+// Unlink sleeping p from its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for (pp = &ptable.sleepq[sleephash(p->chan)]; *pp != 0; pp = &(*pp)->snext)
+  {
+    if (*pp == p)
+    {
+      *pp = p->snext;
+      p->snext = 0;
+      return;
+    }
+  }
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void sleep(void *chan, struct spinlock *lk)
@@ -867,11 +1378,8 @@ void sleep(void *chan, struct spinlock *lk)
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
-
-  if (p->isLock == LOCKED)
-  {
-    schedulerLockDone(1);
-  }
+  sleepqadd(p);
+  MLFQdelete(p); // wakeup1에서 다시 enqueue 된다
 
   sched();
 
@@ -888,20 +1396,28 @@ void sleep(void *chan, struct spinlock *lk)
 
 // PAGEBREAK!
 //  Wake up all processes sleeping on chan.
+//  Only the sleep queue chan hashes to is searched.
 //  The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc **pp, *p;
 
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if (p->state == SLEEPING && p->chan == chan)
+  pp = &ptable.sleepq[sleephash(chan)];
+  while ((p = *pp) != 0)
+  {
+    if (p->chan == chan)
     {
+      *pp = p->snext;
+      p->snext = 0;
       p->state = RUNNABLE;
       p->execTime = 0;
       p->priority = MAXPRIORITY - 1;
       MLFQenqueue(p, 0);
     }
+    else
+      pp = &p->snext;
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -929,7 +1445,11 @@ int kill(int pid)
       p->execTime = 0;
       p->priority = MAXPRIORITY - 1;
       if (p->state == SLEEPING)
+      {
+        sleepqremove(p);
         p->state = RUNNABLE;
+        MLFQenqueue(p, TOP);
+      }
       release(&ptable.lock);
       return 0;
     }
@@ -983,64 +1503,168 @@ int getLevel(void)
 
 void setPriority(int pid, int priority)
 {
-  if (priority < 0 || priority > MAXPRIORITY)
+  if (priority < 0 || priority >= MAXPRIORITY)
     return; // priority can be 0~3 value
 
   acquire(&ptable.lock);
 
-  int found = 0;
-  for (int qLevel = 0; qLevel < MAXQLEVEL && !found; qLevel++)
+  for (struct proc *p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
-    for (int i = 0; i < qtable.mlfQueue[qLevel].rear; i++)
+    if (p->pid != pid || p->state == UNUSED)
+      continue;
+
+    struct mlfq *rq = p->runq;
+    if (rq == 0)
     {
-      if (qtable.mlfQueue[qLevel].procsQueue[i]->pid == pid)
-      {
-        qtable.mlfQueue[qLevel].procsQueue[i]->priority = priority;
-        found = 1;
-        break;
-      };
+      p->priority = priority;
+      break;
+    }
+
+    acquire(&rq->lock);
+    if (p->queue != 0 && p->runq == rq && MLFQisBottom(rq, p->queue) && p->priority != priority)
+    {
+      // move to the rear of the FIFO of the new priority
+      MLFQunlink(p);
+      p->priority = priority;
+      MLFQlink(rq, p, rq->nlevel - 1, 0);
     }
+    else
+      p->priority = priority;
+    release(&rq->lock);
+    break;
   }
 
   release(&ptable.lock);
 }
 
+// Count a timer tick of this cpu, return 1 when its boost period is over.
+// Called from trap() with interrupts disabled.
+int boostTick(void)
+{
+  struct mlfq *rq = mycpu()->mlfq;
+
+  if (++rq->ticks < conf.boostperiod)
+    return 0;
+  rq->ticks = 0;
+  return 1;
+}
+
+// Boost this cpu: processes in its run queues and the one running on it
+// go back to TOP with a fresh time quantum.
 void priorityBoosting(void)
 {
-  acquire(&ptable.lock);
+  struct mlfq *rq;
+  struct proc *p;
+
+  pushcli();
+  rq = mycpu()->mlfq;
+  p = mycpu()->proc;
+
+  // 실행중인 process는 queue에 없으므로 yield에서 TOP으로 enqueue 된다
+  if (p != 0)
+  {
+    p->execTime = 0;
+    p->sliceStart = cpucycles();
+    p->priority = MAXPRIORITY - 1;
+    p->qLevel = TOP;
+  }
+  popcli();
+
+  acquire(&rq->lock);
+  tracesched(EV_BOOST, 0);
 
   // TOP queue에 있는 process의 exectime과 priority 초기화
-  int TopRear = qtable.mlfQueue[TOP].rear;
-  for (int iter = 0; iter < TopRear; iter++)
+  for (p = rq->mlfQueue[TOP].head; p != 0; p = p->qnext)
   {
-    struct proc *p = qtable.mlfQueue[TOP].procsQueue[iter];
-    if (p != 0)
+    p->execTime = 0;
+    p->priority = MAXPRIORITY - 1;
+  }
+
+  // 그 아래 level에 있는 프로세스 초기화 후 TOP에 enqueue
+  for (int qLevel = MIDDLE; qLevel < rq->nlevel; qLevel++)
+  {
+    while ((p = MLFQheadOf(rq, qLevel)) != 0)
     {
+      MLFQunlink(p);
       p->execTime = 0;
       p->priority = MAXPRIORITY - 1;
+      MLFQlink(rq, p, TOP, 0);
     }
   }
 
-  // MIDDLE, BOTTOM에 있는 프로세스 초기화 후 TOP에 enqueue
-  for (int qLevel = MIDDLE; qLevel < MAXQLEVEL; qLevel++)
-  {
-    struct proc *p = MLFQdequeue(qLevel);
+  release(&rq->lock);
+}
 
-    while (p != 0)
+// Relink every process of rq for nlevel active levels. Processes in
+// levels which are gone, or in the last level which is now split by
+// priority, end up in the new last level.
+static void
+MLFQresize(struct mlfq *rq, int nlevel)
+{
+  struct mlfQueue moved = {0, 0, 0};
+  struct proc *p;
+
+  acquire(&rq->lock);
+  for (int qLevel = 0; qLevel < rq->nlevel; qLevel++)
+  {
+    while ((p = MLFQheadOf(rq, qLevel)) != 0)
     {
-      p->execTime = 0;
-      p->priority = MAXPRIORITY - 1;
-      MLFQenqueue(p, TOP);
-      p = MLFQdequeue(qLevel);
+      MLFQunlink(p);
+      listPush(&moved, p, 0);
     }
   }
+  rq->nlevel = nlevel;
+  while ((p = moved.head) != 0)
+  {
+    listRemove(p);
+    MLFQlink(rq, p, p->qLevel, 0);
+  }
+  release(&rq->lock);
+}
 
-  release(&ptable.lock);
+// Set the MLFQ parameters. Return -1 and change nothing if any is out
+// of range.
+int mlfqSetConfig(struct mlfqconf *c)
+{
+  if (c->nlevel < 2 || c->nlevel > MAXQLEVEL)
+    return -1;
+  if (c->boostperiod < 1 || c->boostperiod > MAXQUANTUM)
+    return -1;
+  for (int i = 0; i < c->nlevel; i++)
+    if (c->quantum[i] < 1 || c->quantum[i] > MAXQUANTUM)
+      return -1;
 
-  // priority boosting에 따른 tick 초기화
-  acquire(&tickslock);
-  ticks = 0;
-  release(&tickslock);
+  acquire(&conflock);
+  for (int i = 0; i < c->nlevel; i++)
+    conf.quantum[i] = c->quantum[i];
+  conf.boostperiod = c->boostperiod;
+  if (conf.nlevel != c->nlevel)
+  {
+    conf.nlevel = c->nlevel;
+    for (int i = 0; i < ncpu; i++)
+      MLFQresize(&mlfqs[i], conf.nlevel);
+  }
+  release(&conflock);
+
+  // the real-time lane cannot have more than a boost period
+  acquire(&rtlane.lock);
+  if (rtlane.budget > conf.boostperiod * TICKCYCLES)
+    rtlane.budget = conf.boostperiod * TICKCYCLES;
+  release(&rtlane.lock);
+  return 0;
+}
+
+void mlfqGetConfig(struct mlfqconf *c)
+{
+  acquire(&conflock);
+  *c = conf;
+  release(&conflock);
+}
+
+// ticks between priority boostings
+int mlfqBoostPeriod(void)
+{
+  return conf.boostperiod;
 }
 
 void schedulerLock(int password)
@@ -1051,75 +1675,50 @@ void schedulerLock(int password)
   if (password != SLPASSWORD)
   {
     cprintf("[scheduler lock] Wrong Password!\n");
-    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", curproc->pid, curproc->execTime, curproc->qLevel);
+    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", curproc->pid, curproc->execTime / TICKCYCLES, curproc->qLevel);
     kill(curproc->pid);
     return;
   };
 
-  int pid = curproc->pid;
-  int found = 0;
-  for (struct proc *p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-  {
-    if (pid == p->pid)
-    {
-      found = 1;
-      break;
-    }
-  }
-  // 기존에 존재하던 프로세스가 아니라면, schedulerLock을 호출할 수 없다.
-  if (found == 0)
-    return;
-
-  // 이미 lock이 걸린 process가 있으면 종료한다.
-  if (ltable.proc != 0)
+  // 이미 lock이 걸린 process는 이미 real-time lane에서 실행되고 있다.
+  if (curproc->isLock == LOCKED)
     return;
 
-  MLFQdeleteByPid(pid); // lock된 프로세스는 MLFQ에서 빠져나와서 ltable에 존재하다가 unlock되면 MLFQ로 돌아간다.
-
+  // lock된 프로세스는 MLFQ 대신 real-time lane에서 실행되다가 unlock되면 MLFQ로 돌아간다.
   acquire(&ptable.lock);
+  chargeSlice(curproc);     // lock 전까지 실행한 시간은 MLFQ에 charge
   curproc->isLock = LOCKED; // 현재 프로세스를 LOCKED로 바꿔줌
-  curproc->state = RUNNABLE; // sched 호출을 위해 RUNNABLE로 바꿔줌
-  release(&ptable.lock);
-
-  acquire(&ltable.lock);
-  ltable.proc = curproc; // ltable의 proc을 설정
-  release(&ltable.lock);
-
-  // lock 성공, initialize global tick to 0
-  acquire(&tickslock);
-  ticks = 0;
-  release(&tickslock);
-
-  acquire(&ptable.lock);
+  tracesched(EV_LOCK, curproc);
+  curproc->state = RUNNABLE;
+  MLFQfrontEnqueue(curproc, TOP); // real-time lane의 맨 앞으로 이동
   sched();
   release(&ptable.lock);
 }
 
+// Leave the real-time lane. The caller is the locked process itself,
+// running and so in no queue. An exiting process is not enqueued again.
 void schedulerLockDone(int isExit)
 {
-  struct proc *lockproc = ltable.proc;
-
-  acquire(&ltable.lock);
-  ltable.proc = 0;
-  release(&ltable.lock);
+  struct proc *p = myproc();
 
-  if (lockproc == 0)
-  {
+  if (p->isLock != LOCKED)
     return;
-  }
 
   acquire(&ptable.lock);
-  lockproc->execTime = 0;
-  lockproc->priority = MAXPRIORITY - 1;
-  lockproc->isLock = UNLOCKED;
-
-  enum procstate curState = RUNNABLE;
-  if (lockproc->state != RUNNING || lockproc->state != RUNNABLE)
-    curState = lockproc->state;
-  lockproc->state = curState;
+  chargeSlice(p); // lock된 동안 실행한 시간은 real-time lane의 budget에 charge
+  p->execTime = 0;
+  p->priority = MAXPRIORITY - 1;
+  p->qLevel = TOP;
+  p->isLock = UNLOCKED;
+  tracesched(EV_UNLOCK, p);
 
   if (!isExit)
-    MLFQfrontEnqueue(lockproc, TOP);
+  {
+    // unlock된 프로세스는 TOP의 맨 앞에서 다시 스케줄링된다
+    p->state = RUNNABLE;
+    MLFQfrontEnqueue(p, TOP);
+    sched();
+  }
   release(&ptable.lock);
 }
 
@@ -1129,18 +1728,10 @@ void schedulerUnlock(int password)
   {
     struct proc *p = myproc();
     cprintf("[scheduler unlock] Wrong Password!\n");
-    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime, p->qLevel);
+    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime / TICKCYCLES, p->qLevel);
     kill(p->pid);
     return;
   };
 
-  // TODO: lock되어있는 프로세스가 실행되는 동안은 다른 프로세스는 동작 못하고 있는 건가? 그럼 unlock함수는 무조건 lock된 프로세스(본인)가 호출하는건가? 다른 프로세스에서 호출 가능
-  // TODO: kill process and enqueue in the rear of queue(use original funtion)
-
-  if (ltable.proc == 0)
-  {
-    return;
-  }
-
   schedulerLockDone(0);
 }
@@ -8,6 +8,9 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct mlfq *mlfq;           // MLFQ run queues of this cpu
+  uint timerticks;             // Timer interrupts taken by this cpu
+  volatile uint idle;          // Halted in scheduler() waiting for work
 };
 
 extern struct cpu cpus[NCPU];
@@ -36,7 +39,17 @@ enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 enum queueLevel { TOP = 0, MIDDLE, BOTTOM };
 enum locked { UNLOCKED = 0, LOCKED };
 
-#define TIME_QUANTUM(LEVEL) (2 * LEVEL) + 4
+// time quantum of each level at boot, see mlfq_config
+#define TIME_QUANTUM(LEVEL) ((2 * (LEVEL)) + 4)
+
+// Timer of a sleeping process in the timer wheel (timerwheel.c)
+struct timer {
+  uint expire;                 // wheel tick to wake up at
+  int pending;                 // in the wheel, not expired yet
+  struct timer *next;          // next timer in the same wheel slot
+  struct timer *prev;          // previous timer in the same wheel slot
+  struct timer **head;         // head of the wheel slot
+};
 
 // Per-process state
 struct proc {
@@ -57,10 +70,23 @@ struct proc {
   // member variables for mlfq
   int priority;                // priority of process
   int arrivedTime;             // arrived time
-  int execTime;                // time passed after execution
+  uint execTime;               // lapic timer cycles run in the current level
+  uint sliceStart;             // cpu cycles when last switched in
   enum queueLevel qLevel;      // queue level
-  
+  struct proc *qprev;          // previous process in the same mlfq level
+  struct proc *qnext;          // next process in the same mlfq level
+  struct mlfq *runq;           // run queues of the cpu it last ran on
+  struct mlfQueue *queue;      // mlfq list linked into, 0 if none
+
   enum locked isLock;
+
+  // member variables for stride scheduling
+  int share;                   // percent of cpu time in the stride class, 0 if in mlfq
+  uint pass;                   // stride pass, the lowest one runs next
+  int heapIdx;                 // index in the stride heap + 1, 0 if not in it
+
+  struct proc *snext;          // next sleeper in the same sleep queue
+  struct timer timer;          // wakes up the process from sleep() and nanosleep()
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -71,20 +97,11 @@ struct proc {
 
 struct mlfQueue {
   // RUNNABLE한 프로세스만 저장하는 큐
-
-  // dequeue가 될 때는, 전체 queueProc array를 앞으로 한칸씩 땡겨주는 식으로 구현
-  // enqueue는 단순히 rear가 NPROC보다 큰지 확인하여, rear를 앞으로 한칸 땡겨줌
-
-  //TODO: process가 kill될 때, queue에서도 해당 queue를 삭제
-  int rear;
-  struct proc* procsQueue[NPROC];
-};
-
-struct qLocation
-{
-  int qLevel;
-  int qIndex;
-  int qRear;
+  // proc의 qprev/qnext로 연결된 doubly-linked list이므로
+  // enqueue, frontEnqueue, dequeue, delete 모두 O(1)에 동작한다.
+  // 마지막 level(BOTTOM)은 priority마다 하나씩 FIFO로 나누어 관리한다.
+  struct proc* head;
+  struct proc* tail;
+  int count;
 };
 
-struct proc* MLFQfirstProc(int qLevel);
@@ -0,0 +1,205 @@
+// Print scheduler statistics from the kernel's scheduler trace:
+// queue residence time (enqueue to dispatch) and context switch
+// latency (switch out to next dispatch on the cpu) per MLFQ level,
+// and demotion, boosting and scheduler lock counts.
+//
+// usage: schedstat [command args...]
+// With a command, it is run first and its events are reported.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "schedtrace.h"
+
+#define MAXEV   (NCPU * NSCHEDTRACE)
+#define NBUCKET 12   // buckets of 4^k KiB cycles, last one open ended
+
+struct hist {
+  int n;
+  uint max;
+  int bucket[NBUCKET];
+};
+
+struct schedevent ev[MAXEV];
+struct hist residence[MAXQLEVEL];
+struct hist switchlat[MAXQLEVEL];
+int demotes[MAXQLEVEL];
+int boosts[NCPU];
+int locks, unlocks;
+
+// last enqueue of a process, waiting for its dispatch
+struct {
+  int pid;
+  uint tsc;
+} waiting[NPROC];
+
+// last switch out of each cpu, waiting for the next dispatch
+struct {
+  int valid;
+  uint tsc;
+} switched[NCPU];
+
+void
+addhist(struct hist *h, uint cycles)
+{
+  uint limit;
+  int b;
+
+  limit = 1024;
+  for(b = 0; b < NBUCKET - 1 && cycles >= limit; b++)
+    limit *= 4;
+  h->bucket[b]++;
+  h->n++;
+  if(cycles > h->max)
+    h->max = cycles;
+}
+
+void
+printhist(char *name, int level, struct hist *h)
+{
+  uint limit;
+  int b, i, width;
+
+  printf(1, "%s, level %d: %d samples, max %d cycles\n", name, level, h->n, h->max);
+  if(h->n == 0)
+    return;
+  limit = 1;
+  for(b = 0; b < NBUCKET; b++){
+    if(b < NBUCKET - 1)
+      printf(1, "  < %dK\t%d\t", limit, h->bucket[b]);
+    else
+      printf(1, "  >=%dK\t%d\t", limit / 4, h->bucket[b]);
+    width = h->bucket[b] * 40 / h->n;
+    for(i = 0; i < width; i++)
+      printf(1, "#");
+    printf(1, "\n");
+    limit *= 4;
+  }
+}
+
+// Events of different cpus come in separate runs; order them all by
+// time stamp. Differences keep the order right across tsc wraparound.
+void
+sortevents(int n)
+{
+  struct schedevent e;
+  int i, j;
+
+  for(i = 1; i < n; i++){
+    e = ev[i];
+    for(j = i; j > 0 && (int)(ev[j-1].tsc - e.tsc) > 0; j--)
+      ev[j] = ev[j-1];
+    ev[j] = e;
+  }
+}
+
+int
+waitslot(int pid)
+{
+  int i, free;
+
+  free = -1;
+  for(i = 0; i < NPROC; i++){
+    if(waiting[i].pid == pid)
+      return i;
+    if(waiting[i].pid == 0 && free < 0)
+      free = i;
+  }
+  return free;
+}
+
+void
+account(struct schedevent *e)
+{
+  int i, level;
+
+  level = e->qLevel < MAXQLEVEL ? e->qLevel : MAXQLEVEL - 1;
+  switch(e->type){
+  case EV_ENQUEUE:
+    if((i = waitslot(e->pid)) >= 0){
+      waiting[i].pid = e->pid;
+      waiting[i].tsc = e->tsc;
+    }
+    break;
+  case EV_DEQUEUE:
+    if((i = waitslot(e->pid)) >= 0 && waiting[i].pid == e->pid){
+      addhist(&residence[level], e->tsc - waiting[i].tsc);
+      waiting[i].pid = 0;
+    }
+    if(switched[e->cpu].valid){
+      addhist(&switchlat[level], e->tsc - switched[e->cpu].tsc);
+      switched[e->cpu].valid = 0;
+    }
+    break;
+  case EV_SWITCH:
+    switched[e->cpu].valid = 1;
+    switched[e->cpu].tsc = e->tsc;
+    break;
+  case EV_DEMOTE:
+    demotes[level]++;
+    break;
+  case EV_BOOST:
+    boosts[e->cpu]++;
+    break;
+  case EV_LOCK:
+    locks++;
+    break;
+  case EV_UNLOCK:
+    unlocks++;
+    break;
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, n, pid;
+
+  if(argc > 1){
+    pid = fork();
+    if(pid < 0){
+      printf(2, "schedstat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[1], argv + 1);
+      printf(2, "schedstat: exec %s failed\n", argv[1]);
+      exit();
+    }
+    wait();
+  }
+
+  n = getSchedTrace(ev, MAXEV);
+  if(n < 0){
+    printf(2, "schedstat: getSchedTrace failed\n");
+    exit();
+  }
+  if(n == 0){
+    printf(1, "no scheduler events\n");
+    exit();
+  }
+  sortevents(n);
+  for(i = 0; i < n; i++)
+    account(&ev[i]);
+
+  printf(1, "%d events over %d cycles\n\n", n, ev[n-1].tsc - ev[0].tsc);
+  // levels beyond the active ones (see mlfq_config) have no samples
+  for(i = 0; i < MAXQLEVEL; i++)
+    if(i < NQLEVEL || residence[i].n)
+      printhist("queue residence", i, &residence[i]);
+  printf(1, "\n");
+  for(i = 0; i < MAXQLEVEL; i++)
+    if(i < NQLEVEL || switchlat[i].n)
+      printhist("context switch latency", i, &switchlat[i]);
+  printf(1, "\ndemotions:");
+  for(i = 0; i < MAXQLEVEL; i++)
+    if(i < NQLEVEL || demotes[i])
+      printf(1, " level %d: %d", i, demotes[i]);
+  printf(1, "\nboosts:");
+  for(i = 0; i < NCPU; i++)
+    if(boosts[i])
+      printf(1, " cpu%d: %d", i, boosts[i]);
+  printf(1, "\nscheduler lock: %d, unlock: %d\n", locks, unlocks);
+  exit();
+}
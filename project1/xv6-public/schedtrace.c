@@ -0,0 +1,86 @@
+// Per-cpu ring buffers of scheduler events.
+//
+// Only the owning cpu writes its ring, with interrupts disabled,
+// so recording an event takes no lock. A reader copies a ring while
+// its cpu keeps writing and drops the entries which may have been
+// overwritten meanwhile, judging by the event count of the ring.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "schedtrace.h"
+
+struct tracering {
+  volatile uint head;  // number of events ever recorded
+  struct schedevent ev[NSCHEDTRACE];
+};
+
+static struct tracering rings[NCPU];
+
+// Record an event of type about p (may be 0) in this cpu's ring.
+void
+tracesched(int type, struct proc *p)
+{
+  struct tracering *r;
+  struct schedevent *e;
+  int id;
+
+  pushcli();
+  id = cpuid();
+  r = &rings[id];
+  e = &r->ev[r->head % NSCHEDTRACE];
+  e->tsc = rdtsc();
+  e->ticks = ticks;
+  e->type = type;
+  e->cpu = id;
+  if(p){
+    e->pid = p->pid;
+    e->qLevel = p->qLevel;
+    e->priority = p->priority;
+  } else {
+    e->pid = 0;
+    e->qLevel = 0;
+    e->priority = 0;
+  }
+  // the event must be complete before readers count it
+  __sync_synchronize();
+  r->head++;
+  popcli();
+}
+
+// Copy up to n of the most recent events into dst, cpu by cpu,
+// oldest first within a cpu. Return the number of events copied.
+int
+readschedtrace(struct schedevent *dst, int n)
+{
+  struct tracering *r;
+  uint start, end, head, i, skip;
+  int cnt;
+
+  cnt = 0;
+  for(r = rings; r < &rings[ncpu] && cnt < n; r++){
+    end = r->head;
+    __sync_synchronize();
+    start = end > NSCHEDTRACE ? end - NSCHEDTRACE : 0;
+    if(end - start > n - cnt)
+      start = end - (n - cnt);
+    for(i = start; i < end; i++)
+      dst[cnt + i - start] = r->ev[i % NSCHEDTRACE];
+    __sync_synchronize();
+
+    // events up to head-NSCHEDTRACE may have been overwritten
+    // while they were copied.
+    head = r->head;
+    skip = 0;
+    if(head >= NSCHEDTRACE && head - NSCHEDTRACE + 1 > start)
+      skip = head - NSCHEDTRACE + 1 - start;
+    if(skip > end - start)
+      skip = end - start;
+    memmove(dst + cnt, dst + cnt + skip, (end - start - skip) * sizeof(*dst));
+    cnt += end - start - skip;
+  }
+  return cnt;
+}
@@ -0,0 +1,22 @@
+// Scheduler trace events, shared by the kernel and schedstat.
+
+#define NSCHEDTRACE  256  // events kept per cpu
+
+// event types
+#define EV_ENQUEUE   1  // process put in a run queue
+#define EV_DEQUEUE   2  // process taken out of its run queue to run
+#define EV_DEMOTE    3  // process used up its time quantum
+#define EV_BOOST     4  // priority boosting of a cpu
+#define EV_LOCK      5  // process locked the scheduler
+#define EV_UNLOCK    6  // scheduler lock released
+#define EV_SWITCH    7  // process switched out in sched()
+
+struct schedevent {
+  uint tsc;        // low 32 bits of the time stamp counter
+  uint ticks;      // global ticks
+  int pid;         // process, 0 for EV_BOOST
+  uchar type;      // EV_*
+  uchar cpu;       // cpu which recorded the event
+  uchar qLevel;    // queue level of the process
+  uchar priority;  // priority of the process
+};
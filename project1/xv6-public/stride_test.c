@@ -0,0 +1,140 @@
+// Benchmark of the stride scheduling class.
+// Spinning workers run with different cpu shares next to one MLFQ
+// worker. Every round each worker reports the work it has done, and
+// the cumulative share of the work of each worker is printed, which
+// should converge to the share it asked for with set_cpu_share.
+// The MLFQ worker asks for nothing and gets what is left over.
+//
+// usage: stride_test [nround]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_WORKER 4
+#define NUM_ROUND 10
+#define ROUND_TICKS 100
+#define NUM_SPIN 10000
+
+int share[NUM_WORKER] = {5, 15, 30, 0};
+
+struct report
+{
+  int worker;
+  int round;
+  uint work;
+};
+
+void worker(int w, int nround, int fd)
+{
+  struct report r;
+  volatile int x = 0;
+  int i, now, last, elapsed;
+
+  if (share[w] != 0 && set_cpu_share(getpid(), share[w]) < 0)
+  {
+    printf(1, "worker %d: set_cpu_share %d failed\n", w, share[w]);
+    exit();
+  }
+
+  r.worker = w;
+  r.round = 0;
+  r.work = 0;
+  last = uptime();
+  elapsed = 0;
+  while (r.round < nround)
+  {
+    for (i = 0; i < NUM_SPIN; i++)
+      x++;
+    r.work++;
+    // uptime() restarts from 0 on every boost period
+    now = uptime();
+    elapsed += now >= last ? now - last : now;
+    last = now;
+    if (elapsed >= ROUND_TICKS * (r.round + 1))
+    {
+      r.round++;
+      write(fd, &r, sizeof(r));
+    }
+  }
+  exit();
+}
+
+int main(int argc, char *argv[])
+{
+  uint work[NUM_WORKER];
+  int got[NUM_WORKER];
+  int fd[2];
+  int nround, round, w, n;
+  uint total, measured;
+  struct report r;
+
+  memset(work, 0, sizeof(work));
+  nround = NUM_ROUND;
+  if (argc > 1)
+    nround = atoi(argv[1]);
+
+  if (pipe(fd) < 0)
+  {
+    printf(1, "stride_test: pipe failed\n");
+    exit();
+  }
+
+  printf(1, "stride test: shares");
+  for (w = 0; w < NUM_WORKER; w++)
+    printf(1, " %d%%", share[w]);
+  printf(1, " (0 is the MLFQ worker), %d rounds of %d ticks\n", nround, ROUND_TICKS);
+
+  for (w = 0; w < NUM_WORKER; w++)
+  {
+    int pid = fork();
+    if (pid < 0)
+    {
+      printf(1, "stride_test: fork failed\n");
+      exit();
+    }
+    if (pid == 0)
+    {
+      close(fd[0]);
+      worker(w, nround, fd[1]);
+    }
+  }
+  close(fd[1]);
+
+  // reports of a round come in any order, print a round once all
+  // workers have reported it
+  for (round = 1; round <= nround; round++)
+  {
+    memset(got, 0, sizeof(got));
+    for (n = 0; n < NUM_WORKER;)
+    {
+      if (read(fd[0], &r, sizeof(r)) != sizeof(r))
+      {
+        printf(1, "stride_test: read failed\n");
+        exit();
+      }
+      work[r.worker] = r.work;
+      if (r.round == round && !got[r.worker])
+      {
+        got[r.worker] = 1;
+        n++;
+      }
+    }
+
+    total = 0;
+    for (w = 0; w < NUM_WORKER; w++)
+      total += work[w];
+    printf(1, "round %d:", round);
+    for (w = 0; w < NUM_WORKER; w++)
+    {
+      measured = total == 0 ? 0 : work[w] * 1000 / total;
+      printf(1, "  %d%% -> %d.%d%%", share[w], measured / 10, measured % 10);
+    }
+    printf(1, "\n");
+  }
+
+  for (w = 0; w < NUM_WORKER; w++)
+    wait();
+  close(fd[0]);
+  exit();
+}
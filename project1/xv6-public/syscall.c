@@ -110,6 +110,11 @@ extern int sys_setPriority(void);
 extern int sys_schedulerLock(void);
 extern int sys_schedulerUnlock(void);
 extern int sys_printProcessInfo(void);
+extern int sys_getSchedTrace(void);
+extern int sys_setLockBudget(void);
+extern int sys_set_cpu_share(void);
+extern int sys_mlfq_config(void);
+extern int sys_nanosleep(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -140,6 +145,11 @@ static int (*syscalls[])(void) = {
 [SYS_schedulerLock] sys_schedulerLock,
 [SYS_schedulerUnlock] sys_schedulerUnlock,
 [SYS_printProcessInfo] sys_printProcessInfo,
+[SYS_getSchedTrace] sys_getSchedTrace,
+[SYS_setLockBudget] sys_setLockBudget,
+[SYS_set_cpu_share] sys_set_cpu_share,
+[SYS_mlfq_config] sys_mlfq_config,
+[SYS_nanosleep] sys_nanosleep,
 };
 
 void
@@ -26,4 +26,9 @@
 #define SYS_setPriority 25
 #define SYS_schedulerLock 26
 #define SYS_schedulerUnlock 27
-#define SYS_printProcessInfo 28
\ No newline at end of file
+#define SYS_printProcessInfo 28
+#define SYS_getSchedTrace 29
+#define SYS_setLockBudget 30
+#define SYS_set_cpu_share 31
+#define SYS_mlfq_config 32
+#define SYS_nanosleep 33
\ No newline at end of file
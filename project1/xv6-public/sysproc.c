@@ -6,6 +6,8 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "schedtrace.h"
+#include "mlfqconf.h"
 
 int
 sys_fork(void)
@@ -60,21 +62,20 @@ int
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   if(argint(0, &n) < 0)
     return -1;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(myproc()->killed){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  return timersleep(n);
+}
+
+int
+sys_nanosleep(void)
+{
+  int sec, nsec;
+
+  if(argint(0, &sec) < 0 || argint(1, &nsec) < 0)
+    return -1;
+  return timernanosleep(sec, nsec);
 }
 
 // return how many clock tick interrupts have occurred
@@ -105,7 +106,9 @@ int sys_getLevel(void)
 int sys_setPriority(void)
 {
   int pid = 0, priority = 0;
-  if (argint(0, &pid) < 0 || argint(1, &priority) > MAXPRIORITY)
+  if (argint(0, &pid) < 0 || argint(1, &priority) < 0)
+    return -1;
+  if (priority < 0 || priority >= MAXPRIORITY)
     return -1;
 
   setPriority(pid, priority);
@@ -120,7 +123,7 @@ int sys_schedulerLock(void)
   {
     struct proc *p = myproc();
     cprintf("[scheduler lock] Wrong Password\n");
-    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime, p->qLevel);
+    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime / TICKCYCLES, p->qLevel);
     kill(p->pid);
     return -1;
   };
@@ -138,7 +141,7 @@ int sys_schedulerUnlock(void)
   {
     struct proc *p = myproc();
     cprintf("[scheduler unlock] Wrong Password\n");
-    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime, p->qLevel);
+    cprintf("pid: %d, time quantum: %d, level of queue: %d\n\n", p->pid, p->execTime / TICKCYCLES, p->qLevel);
     kill(p->pid);
     return -1;
   };
@@ -147,9 +150,59 @@ int sys_schedulerUnlock(void)
   return 0;
 }
 
+// ticks of cpu time the scheduler locked processes may run per boost period
+int sys_setLockBudget(void)
+{
+  int ticks;
+
+  if (argint(0, &ticks) < 0)
+    return -1;
+  return rtlaneSetBudget(ticks);
+}
+
+// move a process into the stride class with percent of the cpu time
+int sys_set_cpu_share(void)
+{
+  int pid, percent;
+
+  if (argint(0, &pid) < 0 || argint(1, &percent) < 0)
+    return -1;
+  return setCpuShare(pid, percent);
+}
+
+// set the MLFQ parameters from conf if set is non-zero,
+// then copy the current ones to conf
+int sys_mlfq_config(void)
+{
+  struct mlfqconf *conf;
+  int set;
+
+  if (argptr(0, (void *)&conf, sizeof(*conf)) < 0 || argint(1, &set) < 0)
+    return -1;
+  if (set && mlfqSetConfig(conf) < 0)
+    return -1;
+  mlfqGetConfig(conf);
+  return 0;
+}
+
 int sys_printProcessInfo(void)
 {
   struct proc *p = myproc();
   printProcess("user program", p);
   return p == 0 ? -1 : 0;
 }
+
+// copy the most recent scheduler trace events to user space
+int sys_getSchedTrace(void)
+{
+  struct schedevent *buf;
+  int n;
+
+  if (argint(1, &n) < 0 || n < 0)
+    return -1;
+  if (n > NCPU * NSCHEDTRACE) // n * sizeof(*buf) must not overflow
+    n = NCPU * NSCHEDTRACE;
+  if (argptr(0, (void *)&buf, n * sizeof(*buf)) < 0)
+    return -1;
+  return readschedtrace(buf, n);
+}
@@ -0,0 +1,187 @@
+// Hierarchical timer wheel for sleeping processes.
+//
+// A timer waits in a slot of the wheel level that covers its distance
+// to expiry: level 0 has one slot per tick for the next WHEELSIZE
+// ticks, each higher level slots WHEELSIZE times as many ticks. When
+// the lower level wraps around, the next slot of the level above is
+// cascaded down. On every tick only the timers of one level 0 slot,
+// all expiring now, are woken up.
+//
+// The wheel keeps its own tick count, which unlike ticks is never
+// reset by priority boosting.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+
+#define WHEELBITS  6
+#define WHEELSIZE  (1 << WHEELBITS)
+#define WHEELMASK  (WHEELSIZE - 1)
+#define NWHEEL     4  // levels, timers farther out wait in the last one
+
+struct {
+  struct spinlock lock;
+  uint now;                             // ticks since boot
+  struct timer *slot[NWHEEL][WHEELSIZE];
+} wheel;
+
+void
+timerinit(void)
+{
+  initlock(&wheel.lock, "wheel");
+}
+
+// Link t into the slot for t->expire, which must be after now.
+// wheel.lock must be held.
+static void
+timeradd(struct timer *t)
+{
+  struct timer **head;
+  uint delta, expire;
+  int level;
+
+  delta = t->expire - wheel.now;
+  for(level = 0; level < NWHEEL - 1; level++)
+    if(delta < 1 << (WHEELBITS * (level + 1)))
+      break;
+  expire = t->expire;
+  if(level == NWHEEL - 1 && delta >= 1 << (WHEELBITS * NWHEEL))
+    expire = wheel.now + (1 << (WHEELBITS * NWHEEL)) - 1;
+  head = &wheel.slot[level][(expire >> (WHEELBITS * level)) & WHEELMASK];
+
+  t->pending = 1;
+  t->prev = 0;
+  t->next = *head;
+  if(*head)
+    (*head)->prev = t;
+  *head = t;
+  t->head = head;
+}
+
+// Unlink t from its slot. wheel.lock must be held.
+static void
+timerdel(struct timer *t)
+{
+  if(t->prev)
+    t->prev->next = t->next;
+  else
+    *t->head = t->next;
+  if(t->next)
+    t->next->prev = t->prev;
+  t->next = t->prev = 0;
+  t->head = 0;
+  t->pending = 0;
+}
+
+// Move the timers of the current slot of level down to lower levels.
+static void
+cascade(int level)
+{
+  struct timer **head, *t;
+
+  head = &wheel.slot[level][(wheel.now >> (WHEELBITS * level)) & WHEELMASK];
+  while((t = *head) != 0){
+    timerdel(t);
+    timeradd(t);
+  }
+}
+
+// Advance the wheel by a tick and wake up the sleepers whose timers
+// expire. Called on cpu 0 at every clock interrupt.
+void
+timertick(void)
+{
+  struct timer **head, *t;
+  int level;
+
+  acquire(&wheel.lock);
+  wheel.now++;
+  for(level = 1; level < NWHEEL; level++){
+    if((wheel.now & ((1 << (WHEELBITS * level)) - 1)) != 0)
+      break;
+    cascade(level);
+  }
+  head = &wheel.slot[0][wheel.now & WHEELMASK];
+  while((t = *head) != 0){
+    timerdel(t);
+    wakeup(t);
+  }
+  release(&wheel.lock);
+}
+
+// Sleep until the wheel reaches tick expire.
+// Return -1 if killed meanwhile.
+static int
+sleepuntil(uint expire)
+{
+  struct proc *p = myproc();
+  struct timer *t = &p->timer;
+
+  acquire(&wheel.lock);
+  if((int)(expire - wheel.now) > 0){
+    t->expire = expire;
+    timeradd(t);
+    while(t->pending){
+      if(p->killed){
+        timerdel(t);
+        release(&wheel.lock);
+        return -1;
+      }
+      sleep(t, &wheel.lock);
+    }
+  }
+  release(&wheel.lock);
+  return 0;
+}
+
+// Sleep for n ticks. Return -1 if killed meanwhile.
+int
+timersleep(int n)
+{
+  if(n <= 0)
+    return 0;
+  return sleepuntil(wheel.now + n);
+}
+
+// Sleep for sec seconds and nsec nanoseconds, at the nominal TICKNS
+// nanoseconds per tick. The whole ticks are slept on the wheel. The
+// part of a tick left is waited out by polling the lapic timer, whose
+// period is a tick, giving up the cpu in between.
+// Return -1 if killed meanwhile.
+int
+timernanosleep(int sec, int nsec)
+{
+  uint expire, sub;
+
+  if(sec < 0 || nsec < 0 || nsec >= 1000000000)
+    return -1;
+
+  pushcli();
+  expire = wheel.now + sec * (1000000000 / TICKNS) + nsec / TICKNS;
+  sub = lapictimer() + (nsec % TICKNS) * (TICKCYCLES / TICKNS);
+  popcli();
+  expire += sub / TICKCYCLES;
+  sub %= TICKCYCLES;
+
+  if(sleepuntil(expire) < 0)
+    return -1;
+  for(;;){
+    // the lapic timers of the cpus run in step with that of cpu 0,
+    // which drives the wheel, give or take the time they started apart
+    pushcli();
+    if(wheel.now != expire || lapictimer() >= sub){
+      popcli();
+      break;
+    }
+    popcli();
+    if(myproc()->killed)
+      return -1;
+    yield();
+  }
+  return 0;
+}
@@ -52,22 +52,31 @@ void trap(struct trapframe *tf)
   switch (tf->trapno)
   {
   case T_IRQ0 + IRQ_TIMER:
+    mycpu()->timerticks++;
     if (cpuid() == 0)
     {
       acquire(&tickslock);
       ticks++;
-      wakeup(&ticks);
       release(&tickslock);
-      if (ticks % 100 == 0 && ticks != 0)
+      timertick();
+      if (ticks >= mlfqBoostPeriod())
       {
-        // TODO: ticks 추가
-        if (myproc() != 0 && myproc()->isLock == LOCKED)
-        {
-          schedulerLockDone(0);
-        }
-        priorityBoosting();
+        // locked processes get a fresh real-time lane budget
+        rtlaneRefill();
+
+        // priority boosting에 따른 tick 초기화
+        acquire(&tickslock);
+        ticks = 0;
+        release(&tickslock);
       }
     }
+    // every cpu boosts its own run queues once per boost period
+    if (boostTick())
+      priorityBoosting();
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_WAKEUP:
+    // only wakes this cpu from hlt in scheduler()
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -133,7 +142,7 @@ void trap(struct trapframe *tf)
   if (myproc() && myproc()->state == RUNNING &&
       tf->trapno == T_IRQ0 + IRQ_TIMER)
   {
-    increaseExecTime(myproc());
+    // time run is charged in sched(), no lock is needed here
     yield(); // lock된 것도 yield를 그대로 해준다. 어차피 RUNNABLE인 경우에 대해 scheduler에서 확인을 해주고 context switch를 하므로
   }
 
@@ -34,6 +34,7 @@
 #define IRQ_COM1         4
 #define IRQ_IDE         14
 #define IRQ_ERROR       19
+#define IRQ_WAKEUP      24      // cross-cpu IPI, wakes a halted cpu
 #define IRQ_SPURIOUS    31
 
 // lab04: add trap for int 128
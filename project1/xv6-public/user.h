@@ -1,5 +1,7 @@
 struct stat;
 struct rtcdate;
+struct schedevent;
+struct mlfqconf;
 
 // system calls
 int fork(void);
@@ -22,6 +24,7 @@ int dup(int);
 int getpid(void);
 char* sbrk(int);
 int sleep(int);
+int nanosleep(int sec, int nsec);
 int uptime(void);
 int myfunction(char*);
 
@@ -32,6 +35,10 @@ void setPriority(int pid, int priority);
 void schedulerLock(int password);
 void schedulerUnlock(int password);
 int printProcessInfo(void);
+int getSchedTrace(struct schedevent*, int);
+int setLockBudget(int ticks);
+int set_cpu_share(int pid, int percent);
+int mlfq_config(struct mlfqconf*, int set);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -117,6 +117,14 @@ sti(void)
   asm volatile("sti");
 }
 
+// Enable interrupts and wait for one. sti takes effect only after
+// the next instruction, so no interrupt is taken before hlt.
+static inline void
+stihlt(void)
+{
+  asm volatile("sti; hlt");
+}
+
 static inline uint
 xchg(volatile uint *addr, uint newval)
 {
@@ -130,6 +138,27 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Low 32 bits of the time stamp counter.
+static inline uint
+rdtsc(void)
+{
+  uint lo, hi;
+
+  asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return lo;
+}
+
+// Index of the least significant set bit of v.
+// The result is undefined if v is zero.
+static inline uint
+bsf(uint v)
+{
+  uint idx;
+
+  asm volatile("bsfl %1, %0" : "=r" (idx) : "rm" (v) : "cc");
+  return idx;
+}
+
 static inline uint
 rcr2(void)
 {
@@ -7,6 +7,7 @@ struct proc;
 struct rtcdate;
 struct spinlock;
 struct sleeplock;
+struct procinfo;
 struct stat;
 struct superblock;
 
@@ -80,6 +81,7 @@ extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
 void            lapicstartap(uchar, uint);
+void            lapicipi(int, int);
 void            microdelay(int);
 
 // log.c
@@ -126,12 +128,15 @@ int             setmemorylimit(int pid, int limit); // t2: memory limit 설정
 struct proc*    findProcessByPid(int pid);
 void            showProcessList(void);
 void			cleanThread(struct proc* p);
-void			cleanOtherThreadsForExec(int pid, int tid);
+int             cleanOtherThreadsForExec(void);
 void            makeMainThread(struct proc *p);
 
-int             thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg);
+int             thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg, int stacksize, int tlssize);
 void            thread_exit(void *retval);
 int             thread_join(thread_t thread, void **retval);
+int             thread_join_any(thread_t *thread, void **retval);
+int             getprocinfo(struct procinfo *info, int max); // t8
+int             futex(int *uaddr, int op, int val, int *uaddr2); // t6
 
 // swtch.S
 void            swtch(struct context**, struct context*);
@@ -166,6 +171,7 @@ int             argptr(int, char**, int);
 int             argstr(int, char**);
 int             fetchint(uint, int*);
 int             fetchstr(uint, char**);
+uint            uvaend(uint);
 void            syscall(void);
 
 // timer.c
@@ -192,7 +198,7 @@ int             deallocuvm(pde_t*, uint, uint);
 void            freevm(pde_t*);
 void            inituvm(pde_t*, char*, uint);
 int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
-pde_t*          copyuvm(pde_t*, uint);
+pde_t*          copyuvm(pde_t*, uint, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
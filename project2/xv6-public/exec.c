@@ -23,7 +23,8 @@ int exec(char *path, char **argv)
   pde_t *pgdir, *oldpgdir;
   struct proc *curproc = myproc();
 
-  cleanOtherThreadsForExec(curproc->pid, curproc->tid);
+  if (cleanOtherThreadsForExec() < 0)
+    return -1;
 
   begin_op();
 
@@ -103,14 +104,20 @@ int exec(char *path, char **argv)
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
   // Commit to the user image.
-  oldpgdir = curproc->pgdir;
-  curproc->pgdir = pgdir;
-  curproc->sz = sz;
+  oldpgdir = curproc->share->pgdir;
+  curproc->share->pgdir = pgdir;
+  curproc->share->sz = sz;
   curproc->tf->eip = elf.entry; // main
   curproc->tf->esp = sp;
 
   curproc->stackpages = 1;
-  curproc->mlimit = 0;
+  curproc->share->mlimit = 0;
+  curproc->stack.size = 0;
+  curproc->share->nfreestack = 0;
+  curproc->share->stackbase = USTACKTOP;
+  curproc->tlsbase = 0; // t9. TLS block of the old image
+  curproc->tlssize = 0;
+  curproc->tf->gs = 0;
 
   switchuvm(curproc);
   freevm(oldpgdir);
@@ -138,7 +145,8 @@ int exec2(char *path, char **argv, int stacksize)
   pde_t *pgdir, *oldpgdir;
   struct proc *curproc = myproc();
 
-  cleanOtherThreadsForExec(curproc->pid, curproc->tid);
+  if (cleanOtherThreadsForExec() < 0)
+    return -1;
   if (curproc->mthread != 0 || curproc->tid != 0)
   {
     makeMainThread(curproc);
@@ -222,9 +230,9 @@ int exec2(char *path, char **argv, int stacksize)
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
   // Commit to the user image.
-  oldpgdir = curproc->pgdir;
-  curproc->pgdir = pgdir;
-  curproc->sz = sz;
+  oldpgdir = curproc->share->pgdir;
+  curproc->share->pgdir = pgdir;
+  curproc->share->sz = sz;
   curproc->tf->eip = elf.entry; // main
   curproc->tf->esp = sp;
 
@@ -232,7 +240,15 @@ int exec2(char *path, char **argv, int stacksize)
   curproc->stackpages = stacksize;
 
   // t2. memory limit
-  curproc->mlimit = 0;
+  curproc->share->mlimit = 0;
+
+  // t4. thread stack slots of the old image
+  curproc->stack.size = 0;
+  curproc->share->nfreestack = 0;
+  curproc->share->stackbase = USTACKTOP;
+  curproc->tlsbase = 0; // t9. TLS block of the old image
+  curproc->tlssize = 0;
+  curproc->tf->gs = 0;
 
   switchuvm(curproc);
   freevm(oldpgdir);
@@ -0,0 +1,4 @@
+// t6: futex operations, shared by the kernel and user programs
+#define FUTEX_WAIT    0 // sleep if *addr == val
+#define FUTEX_WAKE    1 // wake up to val waiters
+#define FUTEX_REQUEUE 2 // wake up to val waiters, move the others to addr2
@@ -0,0 +1,188 @@
+// Contention benchmark of the futex based thread_mutex against a
+// spinlock, plus checks of the barrier and the rwlock.
+// Every thread adds to a shared counter in a short critical section.
+// A spinning waiter burns its whole time slice when the holder is
+// preempted, a futex waiter sleeps until the holder hands over.
+//
+// usage: futex_bench [niter]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "uthread.h"
+
+#define NUM_THREAD 4
+#define NUM_ITER 2000
+#define NUM_WORK 200
+#define NUM_ROUND 50
+
+thread_t thread[NUM_THREAD];
+int niter;
+
+volatile int counter;
+volatile int spin;
+thread_mutex_t mutex;
+thread_barrier_t barrier;
+thread_rwlock_t rwlock;
+volatile int pair[2]; // kept equal by the writers of the rwlock test
+int failed;
+
+// some work inside the critical section, so holders get preempted in it
+void work(void)
+{
+  volatile int x = 0;
+  int i;
+
+  for (i = 0; i < NUM_WORK; i++)
+    x++;
+}
+
+void *mutex_thread(void *arg)
+{
+  int i;
+
+  for (i = 0; i < niter; i++)
+  {
+    thread_mutex_lock(&mutex);
+    counter++;
+    work();
+    thread_mutex_unlock(&mutex);
+  }
+  thread_exit(0);
+  return 0;
+}
+
+void *spin_thread(void *arg)
+{
+  int i, old;
+
+  for (i = 0; i < niter; i++)
+  {
+    do
+    {
+      old = 1;
+      asm volatile("lock; xchgl %0, %1" : "+m"(spin), "+r"(old) : : "cc");
+    } while (old != 0);
+    counter++;
+    work();
+    spin = 0;
+  }
+  thread_exit(0);
+  return 0;
+}
+
+void *barrier_thread(void *arg)
+{
+  int round, last, nlast = 0;
+
+  for (round = 0; round < NUM_ROUND; round++)
+  {
+    thread_mutex_lock(&mutex);
+    counter++;
+    thread_mutex_unlock(&mutex);
+    last = thread_barrier_wait(&barrier);
+    nlast += last;
+    // every thread has counted this round before any passes the barrier
+    if (counter < NUM_THREAD * (round + 1))
+      failed = 1;
+    thread_barrier_wait(&barrier);
+  }
+  thread_exit((void *)nlast);
+  return 0;
+}
+
+void *rwlock_thread(void *arg)
+{
+  int i;
+
+  for (i = 0; i < niter; i++)
+  {
+    if ((int)arg == 0 && i % 4 == 0)
+    {
+      thread_rwlock_wrlock(&rwlock);
+      pair[0]++;
+      work();
+      pair[1]++;
+      thread_rwlock_unlock(&rwlock);
+    }
+    else
+    {
+      thread_rwlock_rdlock(&rwlock);
+      if (pair[0] != pair[1])
+        failed = 1;
+      thread_rwlock_unlock(&rwlock);
+    }
+  }
+  thread_exit(0);
+  return 0;
+}
+
+// run NUM_THREAD threads of fn, return the ticks they took
+int run(void *(*fn)(void *), int *sum)
+{
+  int i, start;
+  void *retval;
+
+  start = uptime();
+  for (i = 0; i < NUM_THREAD; i++)
+  {
+    if (thread_create(&thread[i], fn, (void *)i) != 0)
+    {
+      printf(1, "futex_bench: thread_create failed\n");
+      exit();
+    }
+  }
+  *sum = 0;
+  for (i = 0; i < NUM_THREAD; i++)
+  {
+    if (thread_join(thread[i], &retval) != 0)
+    {
+      printf(1, "futex_bench: thread_join failed\n");
+      exit();
+    }
+    *sum += (int)retval;
+  }
+  return uptime() - start;
+}
+
+int main(int argc, char *argv[])
+{
+  int ticks, sum;
+
+  niter = NUM_ITER;
+  if (argc > 1)
+    niter = atoi(argv[1]);
+  printf(1, "futex bench: %d threads, %d iterations\n", NUM_THREAD, niter);
+
+  counter = 0;
+  thread_mutex_init(&mutex);
+  ticks = run(mutex_thread, &sum);
+  printf(1, "futex mutex: %d ticks, counter %d\n", ticks, counter);
+  if (counter != NUM_THREAD * niter)
+    failed = 1;
+
+  counter = 0;
+  spin = 0;
+  ticks = run(spin_thread, &sum);
+  printf(1, "spinlock:    %d ticks, counter %d\n", ticks, counter);
+  if (counter != NUM_THREAD * niter)
+    failed = 1;
+
+  counter = 0;
+  thread_barrier_init(&barrier, NUM_THREAD);
+  ticks = run(barrier_thread, &sum);
+  printf(1, "barrier:     %d ticks, %d rounds\n", ticks, NUM_ROUND);
+  // exactly one thread is the last to arrive in each wait
+  if (sum != 2 * NUM_ROUND)
+    failed = 1;
+
+  thread_rwlock_init(&rwlock);
+  ticks = run(rwlock_thread, &sum);
+  printf(1, "rwlock:      %d ticks, %d writes\n", ticks, pair[0]);
+
+  if (failed)
+    printf(1, "futex bench failed\n");
+  else
+    printf(1, "futex bench ok\n");
+  exit();
+}
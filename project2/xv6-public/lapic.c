@@ -113,6 +113,21 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// t7: Send a fixed interrupt with the given vector to the cpu
+// with the given apic id.
+void
+lapicipi(int apicid, int vector)
+{
+  if(!lapic)
+    return;
+  pushcli(); // ICRHI and ICRLO are written as a pair
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+  popcli();
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
@@ -0,0 +1,122 @@
+// Benchmark of tmalloc against malloc behind one lock, the only safe
+// way to share malloc between threads. Each thread allocates a batch
+// of blocks of mixed sizes, checks them and frees them, for a number
+// of rounds, with 1 up to nthread threads.
+//
+// usage: malloc_bench [nthread]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "uthread.h"
+#include "tmalloc.h"
+
+#define MAX_THREAD 8
+#define NUM_BLOCK 64
+#define NUM_ROUND 200
+
+thread_t thread[MAX_THREAD];
+thread_mutex_t malloclock;
+int usetmalloc;
+int failed;
+
+void *alloc(uint n)
+{
+  void *p;
+
+  if (usetmalloc)
+    return tmalloc(n);
+  thread_mutex_lock(&malloclock);
+  p = malloc(n);
+  thread_mutex_unlock(&malloclock);
+  return p;
+}
+
+void release(void *p)
+{
+  if (usetmalloc)
+  {
+    tfree(p);
+    return;
+  }
+  thread_mutex_lock(&malloclock);
+  free(p);
+  thread_mutex_unlock(&malloclock);
+}
+
+void *thread_main(void *arg)
+{
+  char *block[NUM_BLOCK];
+  uint seed = (int)arg + 1;
+  uint size[NUM_BLOCK];
+  int round, i;
+
+  for (round = 0; round < NUM_ROUND; round++)
+  {
+    for (i = 0; i < NUM_BLOCK; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      size[i] = 8 + (seed >> 16) % 1000;
+      if ((block[i] = alloc(size[i])) == 0)
+      {
+        failed = 1;
+        thread_exit(0);
+      }
+      block[i][0] = block[i][size[i] - 1] = i;
+    }
+    for (i = 0; i < NUM_BLOCK; i++)
+    {
+      if (block[i][0] != i || block[i][size[i] - 1] != i)
+        failed = 1;
+      release(block[i]);
+    }
+  }
+  thread_exit(0);
+  return 0;
+}
+
+int run(int nthread)
+{
+  int i, start;
+  void *retval;
+
+  start = uptime();
+  for (i = 0; i < nthread; i++)
+  {
+    if (thread_create(&thread[i], thread_main, (void *)i) != 0)
+    {
+      printf(1, "malloc_bench: thread_create failed\n");
+      exit();
+    }
+  }
+  for (i = 0; i < nthread; i++)
+    thread_join(thread[i], &retval);
+  return uptime() - start;
+}
+
+int main(int argc, char *argv[])
+{
+  int nthread, n, tlocked, tcached;
+
+  nthread = getncpu();
+  if (argc > 1)
+    nthread = atoi(argv[1]);
+  if (nthread < 1 || nthread > MAX_THREAD)
+    nthread = MAX_THREAD;
+  thread_mutex_init(&malloclock);
+
+  printf(1, "malloc bench: %d blocks of 8 to 1007 bytes, %d rounds per thread\n", NUM_BLOCK, NUM_ROUND);
+  for (n = 1; n <= nthread; n++)
+  {
+    usetmalloc = 0;
+    tlocked = run(n);
+    usetmalloc = 1;
+    tcached = run(n);
+    printf(1, "%d threads: locked malloc %d ticks, tmalloc %d ticks\n", n, tlocked, tcached);
+  }
+  if (failed)
+    printf(1, "malloc bench failed\n");
+  else
+    printf(1, "malloc bench ok\n");
+  exit();
+}
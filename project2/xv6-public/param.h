@@ -10,5 +10,6 @@
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
-#define MAXTHREAD    64 // max cnt of threads
\ No newline at end of file
+#define FSSIZE       2000  // size of file system in blocks
+#define MAXTHREAD    64 // max cnt of threads
+#define MAXTLS       (16*4096) // max bytes of the TLS block of a thread
\ No newline at end of file
@@ -6,12 +6,18 @@
  * kill: 특정 pid의 프로세스를 kill(using kill syscall) & 성공 여부 출력
  * execute <path> <stacksize>: path 경로에 위치한 프로그램을 stacksize 개수만큼의 스택용 페이지와 함께 실행
  * memlim <pid> <limit>:
+ * top [rounds]: 1초마다 thread별 CPU 사용량을 많이 쓴 순서로 rounds번 출력(기본 10번)
  * exit: pmanager 종료
  */
 
 #include "types.h"
 #include "user.h"
 #include "fcntl.h"
+#include "param.h"
+#include "procinfo.h"
+
+#define TOP_INTERVAL 100 // ticks between two top screens
+#define TOP_ROUNDS 10
 
 int getcmd(char *buf, int nbuf)
 {
@@ -39,6 +45,75 @@ int fork1(void)
     return pid;
 }
 
+// t8: top
+struct procinfo cur[NPROC], prev[NPROC];
+int delta[NPROC], order[NPROC];
+
+char *stateName(int state)
+{
+    static char *states[] = {"unused", "embryo", "sleep", "runble", "run", "zombie"};
+
+    if (state < 0 || state >= sizeof(states) / sizeof(states[0]))
+        return "???";
+    return states[state];
+}
+
+/**
+ * 1초(TOP_INTERVAL ticks)마다 getprocinfo snapshot을 받아서
+ * 이전 snapshot과의 rticks 차이(CPU 사용량)가 큰 thread 순서로 출력한다.
+ */
+void top(int rounds)
+{
+    int n, nprev, i, j, k, start, elapsed;
+
+    nprev = getprocinfo(prev, NPROC);
+    start = uptime();
+    for (int r = 0; r < rounds; r++)
+    {
+        sleep(TOP_INTERVAL);
+        n = getprocinfo(cur, NPROC);
+        elapsed = uptime() - start;
+        start = uptime();
+        if (n < 0)
+        {
+            printf(1, "top [failed]: getprocinfo failed\n");
+            return;
+        }
+
+        // 이전 snapshot에서 같은 thread를 찾아 그 사이에 쓴 tick을 구한다
+        for (i = 0; i < n; i++)
+        {
+            delta[i] = cur[i].rticks;
+            for (j = 0; j < nprev; j++)
+            {
+                if (prev[j].pid == cur[i].pid && prev[j].tid == cur[i].tid)
+                {
+                    delta[i] = cur[i].rticks - prev[j].rticks;
+                    break;
+                }
+            }
+
+            // CPU를 많이 쓴 순서로 insertion sort
+            for (k = i; k > 0 && delta[order[k - 1]] < delta[i]; k--)
+                order[k] = order[k - 1];
+            order[k] = i;
+        }
+
+        printf(1, "---------------------------------------------------------------\n");
+        printf(1, "top: %d threads, %d ticks\n", n, elapsed);
+        printf(1, "PID\tTID\tSTATE\tCPU%%\tTICKS\tSWITCH\tMEM\tNAME\n");
+        for (k = 0; k < n; k++)
+        {
+            i = order[k];
+            printf(1, "%d\t%d\t%s\t%d\t%d\t%d\t%d\t%s\n", cur[i].pid, cur[i].tid, stateName(cur[i].state),
+                   elapsed > 0 ? delta[i] * 100 / elapsed : 0, cur[i].rticks, cur[i].nswitch, cur[i].mem, cur[i].name);
+        }
+
+        memmove(prev, cur, n * sizeof(cur[0]));
+        nprev = n;
+    }
+}
+
 int main(void)
 {
     static char buf[100];
@@ -226,6 +301,16 @@ int main(void)
                 exit();
             }
         }
+
+        // top
+        else if (buf[0] == 't' && buf[1] == 'o' && buf[2] == 'p' && (buf[3] == ' ' || buf[3] == '\n'))
+        {
+            int rounds = TOP_ROUNDS;
+
+            if (buf[3] == ' ' && buf[4] >= '0' && buf[4] <= '9')
+                rounds = atoi(buf + 4);
+            top(rounds);
+        }
         else
         {
             printf(1, "error: command not found\n");
@@ -4,13 +4,26 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "x86.h"
+#include "traps.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "sleeplock.h"
+#include "futex.h"
+#include "procinfo.h"
+
+#define SLEEPQBITS 6
+#define NSLEEPQ (1 << SLEEPQBITS) // sleep queues, sleepers hashed by chan
+#define TIDQBITS 6
+#define NTIDQ (1 << TIDQBITS)     // t4: tid index chains, threads hashed by tid
 
 struct
 {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct pshare share[NPROC];   // t5: pshares of the processes, ref 0 if free
+  struct sleeplock aslock[NPROC]; // t4: address space lock of each pshare
+  struct proc *sleepq[NSLEEPQ];
+  struct proc *tidq[NTIDQ];
 } ptable;
 
 static struct proc *initproc;
@@ -21,10 +34,15 @@ extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static int killOtherThreads(struct proc *curproc);
 
 void pinit(void)
 {
+  int i;
+
   initlock(&ptable.lock, "ptable");
+  for (i = 0; i < NPROC; i++)
+    initsleeplock(&ptable.aslock[i], "aspace");
 }
 
 // Must be called with interrupts disabled
@@ -113,9 +131,14 @@ found:
   p->state = EMBRYO;
   p->pid = nextpid++;
   p->stackpages = 1;
-  p->mlimit = 0;
+  p->share = 0;
   p->tid = 0;
   p->mthread = 0;
+  p->stack.size = 0;
+  p->rticks = 0;
+  p->nswitch = 0;
+  p->tlsbase = 0;
+  p->tlssize = 0;
 
   release(&ptable.lock);
 
@@ -144,6 +167,124 @@ found:
   return p;
 }
 
+// t5: Look in the process table for an unused pshare.
+// If found, take it with a single reference and clear it.
+// Otherwise return 0.
+static struct pshare *
+allocshare(void)
+{
+  struct pshare *sh;
+
+  acquire(&ptable.lock);
+  for (sh = ptable.share; sh < &ptable.share[NPROC]; sh++)
+  {
+    if (sh->ref == 0)
+    {
+      memset(sh, 0, sizeof(*sh));
+      sh->ref = 1;
+      sh->stackbase = USTACKTOP;
+      release(&ptable.lock);
+      return sh;
+    }
+  }
+  release(&ptable.lock);
+  return 0;
+}
+
+// t4: The lock serializing changes to the address space of sh:
+// its sz, stackbase and the mappings of pgdir below them.
+static struct sleeplock *
+aslock(struct pshare *sh)
+{
+  return &ptable.aslock[sh - ptable.share];
+}
+
+// t2: Memory used by sh, the heap and the thread stacks, for mlimit.
+static uint
+usedmem(struct pshare *sh)
+{
+  return sh->sz + (USTACKTOP - sh->stackbase);
+}
+
+// t5: p가 더 이상 pshare를 쓰지 않는다. 마지막 thread일 때만 address space를 해제한다.
+// open file과 cwd는 마지막 thread가 exit에서 이미 닫았어야 한다.
+// ptable.lock must be held.
+static void
+putshare(struct proc *p)
+{
+  struct pshare *sh = p->share;
+
+  p->share = 0;
+  if (sh == 0 || --sh->ref > 0)
+    return;
+  if (sh->pgdir)
+    freevm(sh->pgdir);
+  sh->pgdir = 0;
+}
+
+// t4: tid index. tids are handed out in sequence, so the low bits spread them.
+// The ptable lock must be held by these.
+static void
+tidadd(struct proc *p)
+{
+  struct proc **pp = &ptable.tidq[p->tid & (NTIDQ - 1)];
+
+  p->tnext = *pp;
+  *pp = p;
+}
+
+static void
+tidremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for (pp = &ptable.tidq[p->tid & (NTIDQ - 1)]; *pp != 0; pp = &(*pp)->tnext)
+  {
+    if (*pp == p)
+    {
+      *pp = p->tnext;
+      p->tnext = 0;
+      return;
+    }
+  }
+}
+
+// The thread with the given tid, or 0.
+static struct proc *
+tidlookup(thread_t tid)
+{
+  struct proc *p;
+
+  for (p = ptable.tidq[tid & (NTIDQ - 1)]; p != 0; p = p->tnext)
+    if (p->tid == tid)
+      return p;
+  return 0;
+}
+
+// t4: exited threads of a process wait in its zombies list until joined.
+// The ptable lock must be held by these.
+static void
+zombieadd(struct pshare *sh, struct proc *p)
+{
+  p->zprev = 0;
+  p->znext = sh->zombies;
+  if (sh->zombies)
+    sh->zombies->zprev = p;
+  sh->zombies = p;
+}
+
+static void
+zombieremove(struct pshare *sh, struct proc *p)
+{
+  if (p->zprev)
+    p->zprev->znext = p->znext;
+  else
+    sh->zombies = p->znext;
+  if (p->znext)
+    p->znext->zprev = p->zprev;
+  p->znext = p->zprev = 0;
+}
+
 // PAGEBREAK: 32
 //  Set up first user process.
 void userinit(void)
@@ -154,10 +295,10 @@ void userinit(void)
   p = allocproc();
 
   initproc = p;
-  if ((p->pgdir = setupkvm()) == 0)
+  if ((p->share = allocshare()) == 0 || (p->share->pgdir = setupkvm()) == 0)
     panic("userinit: out of memory?");
-  inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
-  p->sz = PGSIZE;
+  inituvm(p->share->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
+  p->share->sz = PGSIZE;
   memset(p->tf, 0, sizeof(*p->tf));
   p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
   p->tf->ds = (SEG_UDATA << 3) | DPL_USER;
@@ -168,7 +309,7 @@ void userinit(void)
   p->tf->eip = 0; // beginning of initcode.S
 
   safestrcpy(p->name, "initcode", sizeof(p->name));
-  p->cwd = namei("/");
+  p->share->cwd = namei("/");
 
   // this assignment to p->state lets other cores
   // run this process. the acquire forces the above
@@ -182,40 +323,43 @@ void userinit(void)
 }
 
 // Grow current process's memory by n bytes.
-// Return 0 on success, -1 on failure.
+// t4: The heap grows up to the thread stacks, under the address space lock,
+// so threads calling sbrk at the same time each get their own range.
+// Return the old size on success, -1 on failure.
 int growproc(int n)
 {
-  uint sz;
+  uint sz, oldsz;
   struct proc *curproc = myproc();
-  struct proc *mthread = curproc->mthread;
+  struct pshare *sh = curproc->share; // t5: 모든 thread가 같은 address space를 키운다
 
-  if (!(mthread) || curproc->tid == 0) // mthread가 없으면, 본인이 mthread라는 뜻이므로
-    mthread = curproc;                 // mthread를 current proc으로 설정해준다.
-
-  sz = mthread->sz;
+  acquiresleep(aslock(sh));
+  sz = oldsz = sh->sz;
 
   if (n > 0)
   {
     // t2: exceed memory limitation
-    if (mthread->mlimit != 0 && sz + n > mthread->mlimit)
-    {
-      // TODO: sub thread도 memory limit를 개별적으로 가지나?
-      // 애초에 sub thread는 이전의 합이 아닌 본인만의 memory를 가지는게 맞... 가 아니라 stack bottom을 저장하는 거니까 커지는게 맞구나
-      // 그러면 mthread의 sz가 커지면 안되는거 아닌가? 흠 mthread만의 stack 크기만을 가져야하는데...
-      return -1;
-    }
-
-    if ((sz = allocuvm(mthread->pgdir, sz, sz + n)) == 0)
-      return -1;
+    if (sh->mlimit != 0 && usedmem(sh) + n > sh->mlimit)
+      goto bad;
+    // heap이 thread stack 영역을 침범하지 않도록
+    if (sz + n > sh->stackbase || sz + n < sz)
+      goto bad;
+
+    if ((sz = allocuvm(sh->pgdir, sz, sz + n)) == 0)
+      goto bad;
   }
   else if (n < 0)
   {
-    if ((sz = deallocuvm(mthread->pgdir, sz, sz + n)) == 0)
-      return -1;
+    if ((sz = deallocuvm(sh->pgdir, sz, sz + n)) == 0)
+      goto bad;
   }
-  mthread->sz = sz;
+  sh->sz = sz;
+  releasesleep(aslock(sh));
   switchuvm(curproc);
-  return 0;
+  return oldsz;
+
+bad:
+  releasesleep(aslock(sh));
+  return -1;
 }
 
 // Create a new process copying p as the parent.
@@ -234,16 +378,30 @@ int fork(void)
   }
 
   // Copy process state from proc.
-  if ((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0)
+  if ((np->share = allocshare()) != 0)
+  {
+    // 다른 thread가 동시에 address space를 바꾸지 못하도록
+    acquiresleep(aslock(curproc->share));
+    np->share->pgdir = copyuvm(curproc->share->pgdir, curproc->share->sz, curproc->share->stackbase);
+    np->share->sz = curproc->share->sz;
+    np->share->stackbase = curproc->share->stackbase;
+    releasesleep(aslock(curproc->share));
+  }
+  if (np->share == 0 || np->share->pgdir == 0)
   {
+    acquire(&ptable.lock);
+    putshare(np);
+    release(&ptable.lock);
     kfree(np->kstack);
     np->kstack = 0;
     np->state = UNUSED;
     return -1;
   }
-  np->sz = curproc->sz;
   *np->tf = *curproc->tf;
-  np->mlimit = curproc->mlimit;
+  np->share->mlimit = curproc->share->mlimit;
+  // t9: the TLS block was copied along with the thread stacks
+  np->tlsbase = curproc->tlsbase;
+  np->tlssize = curproc->tlssize;
 
   if (np->tid == 0)
   {
@@ -258,9 +416,9 @@ int fork(void)
   np->tf->eax = 0;
 
   for (i = 0; i < NOFILE; i++)
-    if (curproc->ofile[i])
-      np->ofile[i] = filedup(curproc->ofile[i]);
-  np->cwd = idup(curproc->cwd);
+    if (curproc->share->ofile[i])
+      np->share->ofile[i] = filedup(curproc->share->ofile[i]);
+  np->share->cwd = idup(curproc->share->cwd);
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
 
@@ -290,31 +448,39 @@ void exit(void)
   // exit all threads
   acquire(&ptable.lock);
 
-  // clean other threads
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  // t7: 다른 thread가 이미 process를 정리하고 있으면 그 thread가 curproc을 정리한다
+  if (killOtherThreads(curproc) < 0)
   {
-    if (p->pid == curproc->pid && p->tid != curproc->tid) // pid는 같은데 process가 같지는 않은 경우
-    {
-      cleanThread(p);
-    }
+    if (curproc->tid != 0)
+      zombieadd(curproc->share, curproc);
+    curproc->state = ZOMBIE;
+    wakeup1(&curproc->share->exiting);
+    sched();
+    panic("zombie exit");
   }
+  // exit하는 thread가 process로 남아 wait에서 정리된다
+  if (curproc->tid != 0)
+    tidremove(curproc);
+  curproc->tid = 0;
+  curproc->mthread = 0;
 
   release(&ptable.lock);
 
   // Close all open files.
+  // t5: 다른 thread가 모두 정리되었으므로 curproc이 pshare의 마지막 사용자이다.
   for (fd = 0; fd < NOFILE; fd++)
   {
-    if (curproc->ofile[fd])
+    if (curproc->share->ofile[fd])
     {
-      fileclose(curproc->ofile[fd]);
-      curproc->ofile[fd] = 0;
+      fileclose(curproc->share->ofile[fd]);
+      curproc->share->ofile[fd] = 0;
     }
   }
 
   begin_op();
-  iput(curproc->cwd);
+  iput(curproc->share->cwd);
   end_op();
-  curproc->cwd = 0;
+  curproc->share->cwd = 0;
 
   acquire(&ptable.lock);
 
@@ -353,16 +519,20 @@ int wait(void)
     havekids = 0;
     for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     {
-      if (p->parent != curproc)
+      if (p->parent != curproc || p->tid != 0) // t4: threads are reaped by thread_join
         continue;
       havekids = 1;
+      // t7: 다른 thread가 process를 정리하는 중이면 그 thread가 exit할 때까지 기다린다.
+      // kill된 main thread는 그 thread가 cleanThread하고, 같은 pid로 그 thread가 ZOMBIE가 된다.
+      if (p->share && p->share->exiting != 0 && p->share->exiting != p)
+        continue;
       if (p->state == ZOMBIE)
       {
         // Found one.
         pid = p->pid;
         kfree(p->kstack);
         p->kstack = 0;
-        freevm(p->pgdir);
+        putshare(p);
         p->pid = 0;
         p->parent = 0;
         p->name[0] = 0;
@@ -417,6 +587,7 @@ void scheduler(void)
       c->proc = p;
       switchuvm(p);
       p->state = RUNNING;
+      p->nswitch++;
 
       swtch(&(c->scheduler), p->context);
       switchkvm();
@@ -484,6 +655,42 @@ void forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// Sleep queue of the processes sleeping on chan.
+static uint
+sleephash(void *chan)
+{
+  return ((uint)chan * 2654435761U) >> (32 - SLEEPQBITS);
+}
+
+// Link p, which is going to sleep on p->chan, into its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqadd(struct proc *p)
+{
+  struct proc **pp = &ptable.sleepq[sleephash(p->chan)];
+
+  p->snext = *pp;
+  *pp = p;
+}
+
+// Unlink sleeping p from its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for (pp = &ptable.sleepq[sleephash(p->chan)]; *pp != 0; pp = &(*pp)->snext)
+  {
+    if (*pp == p)
+    {
+      *pp = p->snext;
+      p->snext = 0;
+      return;
+    }
+  }
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void sleep(void *chan, struct spinlock *lk)
@@ -510,6 +717,7 @@ void sleep(void *chan, struct spinlock *lk)
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  sleepqadd(p);
 
   sched();
 
@@ -526,15 +734,25 @@ void sleep(void *chan, struct spinlock *lk)
 
 // PAGEBREAK!
 //  Wake up all processes sleeping on chan.
+//  Only the sleep queue chan hashes to is searched.
 //  The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc **pp, *p;
 
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if (p->state == SLEEPING && p->chan == chan)
+  pp = &ptable.sleepq[sleephash(chan)];
+  while ((p = *pp) != 0)
+  {
+    if (p->chan == chan)
+    {
+      *pp = p->snext;
+      p->snext = 0;
       p->state = RUNNABLE;
+    }
+    else
+      pp = &p->snext;
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -545,28 +763,207 @@ void wakeup(void *chan)
   release(&ptable.lock);
 }
 
+// t6: Wake up the nwake oldest processes sleeping on chan.
+// If chan2 is non-zero, the other sleepers on chan are moved to chan2.
+// Sleepers are pushed on the front of their queue, so the oldest are at the back.
+// The ptable lock must be held. Return the number woken up.
+static int
+wakeupn(void *chan, int nwake, void *chan2)
+{
+  struct proc **pp, *p, *moved;
+  int n, skip;
+
+  n = 0;
+  for (p = ptable.sleepq[sleephash(chan)]; p != 0; p = p->snext)
+    if (p->chan == chan)
+      n++;
+  skip = n > nwake ? n - nwake : 0;
+
+  moved = 0;
+  n = 0;
+  pp = &ptable.sleepq[sleephash(chan)];
+  while ((p = *pp) != 0)
+  {
+    if (p->chan != chan)
+    {
+      pp = &p->snext;
+    }
+    else if (skip > 0)
+    {
+      skip--;
+      if (chan2 == 0)
+      {
+        pp = &p->snext;
+        continue;
+      }
+      *pp = p->snext;
+      p->snext = moved; // youngest first, so moved ends up oldest first
+      moved = p;
+    }
+    else
+    {
+      *pp = p->snext;
+      p->snext = 0;
+      p->state = RUNNABLE;
+      n++;
+    }
+  }
+
+  // queue the moved sleepers behind those already sleeping on chan2
+  while ((p = moved) != 0)
+  {
+    moved = p->snext;
+    p->chan = chan2;
+    sleepqadd(p);
+  }
+  return n;
+}
+
 // Kill the process with the given pid.
 // Process won't exit until it returns
 // to user space (see trap in trap.c).
+// t7: Make killed p notice it soon. Wake it if it is sleeping, and
+// interrupt the cpu running it so that it traps out of user space.
+// The ptable lock must be held.
+static void
+kickThread(struct proc *p)
+{
+  struct cpu *c;
+
+  if (p->state == SLEEPING)
+  {
+    sleepqremove(p);
+    p->state = RUNNABLE;
+  }
+  else if (p->state == RUNNING)
+  {
+    for (c = cpus; c < &cpus[ncpu]; c++)
+      if (c->proc == p && c != mycpu())
+        lapicipi(c->apicid, T_IRQ0 + IRQ_KICK);
+  }
+}
+
+// Kill the process with the given pid.
+// t7: Every thread(LWP) of the process is marked, and
+// the first one to get back to user space takes the others down (see exit).
 int kill(int pid)
 {
   struct proc *p;
+  int found = 0;
 
   acquire(&ptable.lock);
   for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
   {
-    if (p->pid == pid)
+    if (p->pid == pid && p->state != UNUSED)
     {
       p->killed = 1;
-      // Wake process from sleep if necessary.
-      if (p->state == SLEEPING)
-        p->state = RUNNABLE;
-      release(&ptable.lock);
+      kickThread(p);
+      found = 1;
+    }
+  }
+  release(&ptable.lock);
+  return found ? 0 : -1;
+}
+
+/**
+ * t7: curproc을 제외한 process의 모든 thread를 kill하고 정리한다.
+ * 다른 cpu에서 실행 중이거나 kernel 안에 있는 thread의 kernel stack을 바로 해제하면 안 되므로,
+ * 각 thread가 스스로 exit에 도착해 ZOMBIE가 될 때까지 기다린 뒤 cleanThread한다.
+ * ptable.lock must be held; it is released while waiting.
+ * return: 정리했으면 0, 다른 thread가 이미 process를 정리하고 있으면 -1
+ */
+static int
+killOtherThreads(struct proc *curproc)
+{
+  struct pshare *sh = curproc->share;
+  struct proc *p, *q;
+  int alive;
+
+  if (sh->exiting != 0 && sh->exiting != curproc)
+    return -1;
+  sh->exiting = curproc; // 이후 thread_create는 실패한다
+
+  for (;;)
+  {
+    alive = 0;
+    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    {
+      if (p == curproc || p->share != sh)
+        continue;
+      if (p->state != ZOMBIE)
+      {
+        p->killed = 1;
+        kickThread(p);
+        alive = 1;
+        continue;
+      }
+      // thread가 fork한 자식은 curproc이 넘겨받는다
+      for (q = ptable.proc; q < &ptable.proc[NPROC]; q++)
+        if (q->parent == p)
+          q->parent = curproc;
+      cleanThread(p);
+    }
+    if (!alive)
       return 0;
+    // Woken up by each thread getting to exit.
+    sleep(&sh->exiting, &ptable.lock);
+  }
+}
+
+// t6: Kernel address of the user futex word at uaddr, which keys it:
+// threads sharing the pgdir and processes sharing the page get the same key.
+// Return 0 if uaddr is unaligned or not mapped.
+static int *
+futexkey(int *uaddr)
+{
+  char *page;
+
+  if ((uint)uaddr % sizeof(int) != 0 || uvaend((uint)uaddr) == 0)
+    return 0;
+  if ((page = uva2ka(myproc()->share->pgdir, (char *)uaddr)) == 0)
+    return 0;
+  return (int *)(page + ((uint)uaddr & (PGSIZE - 1)));
+}
+
+/**
+ * t6: futex
+ * FUTEX_WAIT: *uaddr가 아직 val이면 FUTEX_WAKE될 때까지 잔다. 값이 다르면 -1
+ * FUTEX_WAKE: uaddr에서 자는 thread를 최대 val개 깨운다.
+ * FUTEX_REQUEUE: 최대 val개를 깨우고, 나머지는 깨우지 않고 uaddr2에서 자게 옮긴다.
+ * return: WAIT은 깨어나면 0, WAKE와 REQUEUE는 깨운 thread 개수, 에러가 있으면 -1
+ */
+int futex(int *uaddr, int op, int val, int *uaddr2)
+{
+  int *key, *key2 = 0;
+  int n;
+
+  if ((key = futexkey(uaddr)) == 0)
+    return -1;
+  if (op == FUTEX_REQUEUE && (key2 = futexkey(uaddr2)) == 0)
+    return -1;
+
+  acquire(&ptable.lock);
+  switch (op)
+  {
+  case FUTEX_WAIT:
+    // checked under ptable.lock, so a FUTEX_WAKE after the store cannot be missed
+    if (*key != val || myproc()->killed)
+    {
+      release(&ptable.lock);
+      return -1;
     }
+    sleep(key, &ptable.lock);
+    n = 0;
+    break;
+  case FUTEX_WAKE:
+  case FUTEX_REQUEUE:
+    n = wakeupn(key, val, key2);
+    break;
+  default:
+    n = -1;
   }
   release(&ptable.lock);
-  return -1;
+  return n;
 }
 
 /**
@@ -596,14 +993,14 @@ int setmemorylimit(int pid, int limit)
 
   if (p->pid == pid)
   {
-    if (limit < p->sz) // 기존 할당받은 메모리보다 limit가 작은 경우 -1 반환
+    if (limit < usedmem(p->share)) // 기존 할당받은 메모리보다 limit가 작은 경우 -1 반환
     {
       return -1;
     }
     else
     {
       acquire(&ptable.lock);
-      p->mlimit = limit;
+      p->share->mlimit = limit;
       release(&ptable.lock);
     }
   }
@@ -611,6 +1008,33 @@ int setmemorylimit(int pid, int limit)
   return 0; // 정상 동작, 0 반환
 }
 
+/**
+ * t8: copy a snapshot of up to max threads into info, in one pass over ptable
+ * return: 복사한 thread 개수
+ */
+int getprocinfo(struct procinfo *info, int max)
+{
+  struct proc *p;
+  int n = 0;
+
+  acquire(&ptable.lock);
+  for (p = ptable.proc; p < &ptable.proc[NPROC] && n < max; p++)
+  {
+    if (p->state == UNUSED || p->state == EMBRYO || p->share == 0)
+      continue;
+    info[n].pid = p->pid;
+    info[n].tid = p->tid;
+    info[n].state = p->state;
+    info[n].rticks = p->rticks;
+    info[n].nswitch = p->nswitch;
+    info[n].mem = usedmem(p->share);
+    safestrcpy(info[n].name, p->name, sizeof(info[n].name));
+    n++;
+  }
+  release(&ptable.lock);
+  return n;
+}
+
 /**
  * t3: pmanager show process list
  */
@@ -628,8 +1052,8 @@ void showProcessList(void)
         cprintf("name: %s | ", p->name);
         cprintf("pid: %d | ", p->pid);
         cprintf("stack pages: %d | ", p->stackpages);
-        cprintf("memory: %d | ", p->sz);
-        cprintf("memlim: %d | ", p->mlimit);
+        cprintf("memory: %d | ", usedmem(p->share));
+        cprintf("memlim: %d | ", p->share->mlimit);
         cprintf("\n");
         struct proc *q;
 
@@ -648,11 +1072,25 @@ void showProcessList(void)
   cprintf("---------------------------------------------------------------\n");
 }
 
+// ptable.lock must be held.
 void cleanThread(struct proc *p)
 {
+  if (p->state == SLEEPING)
+    sleepqremove(p);
+  if (p->tid != 0)
+  {
+    // exited threads are in the zombies list until joined, see thread_exit
+    if (p->state == ZOMBIE)
+      zombieremove(p->share, p);
+    tidremove(p);
+  }
+  // one thread less to wait for in thread_join_any
+  if (p->share && p->share->nanyjoin > 0)
+    wakeup1(p->share);
   p->state = UNUSED;
   kfree(p->kstack);
   p->kstack = 0;
+  putshare(p);
   p->pid = 0;
   p->parent = 0;
   p->killed = 0;
@@ -661,49 +1099,111 @@ void cleanThread(struct proc *p)
   p->mthread = 0;
 }
 
-void cleanOtherThreadsForExec(int pid, int tid)
+// t5: open file과 cwd는 pshare에 있으므로 exec 이후에도 그대로 쓴다
+// Return -1 if another thread is taking the process down.
+int cleanOtherThreadsForExec(void)
 {
-  struct proc *p;
+  struct proc *curproc = myproc();
+  int r;
 
   acquire(&ptable.lock);
-
-  for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-  {
-    if (p->pid == pid && p->tid != tid)
-    {
-      release(&ptable.lock);
-      // Close all open files.
-      int fd;
-      for (fd = 0; fd < NOFILE; fd++)
-      {
-        if (p->ofile[fd])
-        {
-          fileclose(p->ofile[fd]);
-          p->ofile[fd] = 0;
-        }
-      }
-
-      begin_op();
-      iput(p->cwd);
-      end_op();
-      p->cwd = 0;
-
-      acquire(&ptable.lock);
-      cleanThread(p);
-    }
-  }
-
+  if ((r = killOtherThreads(curproc)) == 0)
+    curproc->share->exiting = 0;
   release(&ptable.lock);
+  return r;
 }
 
 void makeMainThread(struct proc *p)
 {
   acquire(&ptable.lock);
+  if (p->tid != 0)
+    tidremove(p);
   p->mthread = 0;
   p->tid = 0;
   release(&ptable.lock);
 }
 
+/**
+ * t4: thread stack slot pool
+ * sh의 freestack에서 stacksize page의 stack을 가진 slot을 찾아 slot에 담는다.
+ * 맞는 slot이 여러 개면 가장 작은 것을 쓰고, 없으면 thread stack 영역 아래에 새로 할당한다.
+ * thread stack 영역은 USTACKTOP에서 heap 쪽으로 자라므로 heap과 섞이지 않는다.
+ * return: 성공하면 0, memory가 없거나 memory limit을 넘으면 -1
+ */
+static int
+takeStackSlot(struct pshare *sh, int stacksize, struct stackslot *slot)
+{
+  uint need = (stacksize + 1) * PGSIZE; // +1 for guard page
+  uint base;
+  int i, best = -1;
+
+  acquire(&ptable.lock);
+  for (i = 0; i < sh->nfreestack; i++)
+  {
+    if (sh->freestack[i].size >= need &&
+        (best < 0 || sh->freestack[i].size < sh->freestack[best].size))
+      best = i;
+  }
+  if (best >= 0)
+  {
+    *slot = sh->freestack[best];
+    sh->freestack[best] = sh->freestack[--sh->nfreestack];
+    release(&ptable.lock);
+    return 0;
+  }
+  release(&ptable.lock);
+
+  acquiresleep(aslock(sh));
+  // memory limit을 초과하거나 heap과 겹치는지 확인
+  base = sh->stackbase - need;
+  if ((sh->mlimit != 0 && usedmem(sh) + need > sh->mlimit) ||
+      need > sh->stackbase || base < PGROUNDUP(sh->sz))
+  {
+    releasesleep(aslock(sh));
+    return -1;
+  }
+  if (allocuvm(sh->pgdir, base, base + need) == 0)
+  {
+    releasesleep(aslock(sh));
+    return -1;
+  }
+  clearpteu(sh->pgdir, (char *)base); // guard page에 접근할 수 없도록 설정
+
+  // 이후 stack은 이 slot 아래에 차곡차곡 할당된다
+  sh->stackbase = base;
+  releasesleep(aslock(sh));
+  slot->base = base;
+  slot->size = need;
+  return 0;
+}
+
+// t4: 다 쓴 stack slot을 sh의 freestack에 돌려준다. 가득 차 있으면 버린다.
+// ptable.lock must be held.
+static void
+putStackSlot(struct pshare *sh, struct stackslot *slot)
+{
+  if (slot->size != 0 && sh->nfreestack < MAXTHREAD)
+    sh->freestack[sh->nfreestack++] = *slot;
+  slot->size = 0;
+}
+
+// t9: TLS block을 0으로 채우고 첫 word에 block 자신의 주소를 넣는다.
+// i386의 TCB처럼 %gs:0으로 block의 flat 주소를 얻을 수 있다.
+static int
+initTLS(pde_t *pgdir, uint base, uint size)
+{
+  static char zero[128];
+  uint off, n;
+
+  for (off = 0; off < size; off += n)
+  {
+    n = size - off < sizeof(zero) ? size - off : sizeof(zero);
+    if (copyout(pgdir, base + off, zero, n) < 0)
+      return -1;
+  }
+  return copyout(pgdir, base, &base, sizeof(base));
+}
+
 // t4: threading
 /**
  * create new thread: fork & exec
@@ -711,14 +1211,17 @@ void makeMainThread(struct proc *p)
  * start_routine: 스레드가 시작할 함수를 지정
  *    스레드는 start_routine이 가리키는 함수에서 시작하게 됨
  * arg: 스레드의 start_routine에 전달할 인자
+ * stacksize: 스레드의 user stack page 개수
+ * tlssize: t9. 스레드의 TLS block byte 수(0이면 TLS 없음)
+ *    block은 stack slot의 가장 위에 두고, 첫 word(block 주소) 뒤에 tlssize byte가 온다.
  * return: 스레드가 성공적으로 만들어진 경우: 0, 에러가 있으면 -1
  */
-int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
+int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg, int stacksize, int tlssize)
 {
   /* fork part */
   // allocproc을 통해 새로운 프로세스 공간을 할당(프로세스를 생성하는 것처럼 스레드를 생성)
   // 각종 멤버 변수 초기화를 해주는 part
-  // 단, 프로세스 fork와 다르게 기존 pgdir을 복사하지 않고, main thread의 pgdir을 그대로 사용, 공유 리소스(data, text 등)를 공유
+  // 단, 프로세스 fork와 다르게 기존 pgdir을 복사하지 않고, main thread의 pshare(pgdir, open file, cwd 등)를 그대로 공유
   // register 정보, stack은 따로 둔다.
 
   struct proc *np;
@@ -754,63 +1257,49 @@ int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
   // Clear %eax so that fork returns 0 in the child.
   np->tf->eax = 0;
 
-  // copy opened file
-  for (int i = 0; i < NOFILE; i++)
-    if (mthread->ofile[i])
-      np->ofile[i] = filedup(mthread->ofile[i]);
-
-  // copy current directory
-  np->cwd = idup(mthread->cwd);
-
   // copy the name of process
   safestrcpy(np->name, mthread->name, sizeof(mthread->name));
 
   /* exec part */
-  pde_t *pgdir = mthread->pgdir; // 원래의 pgdir을 새로 복사한 페이지가 아닌, mthread가 사용하는 pgdir을 그대로 사용(메모리 공간 공유)
-  uint sz = mthread->sz;
-  uint sp = sz;
-
+  struct pshare *sh = mthread->share; // t5: pgdir, open file, cwd를 복사하지 않고 참조만 늘려서 공유
+  uint sp, top;
   uint arguments[2];
-
-  // TODO: user stack에 남는 메모리 공간이 있는지 확인하는 로직 추가
+  uint tlspages = tlssize > 0 ? PGROUNDUP(tlssize + sizeof(uint)) / PGSIZE : 0;
 
   // user stack을 새롭게 할당해줌(stack은 공유하지 않으므로)
-  // 2개의 PGSIZE 할당: 하나는 user stack, 하나는 guard page
-  if ((sz = allocuvm(pgdir, sz, sz + 2 * PGSIZE)) == 0)
-  {
+  // guard page 하나와 stacksize개의 stack page로 된 slot을 사용한다.
+  // join된 thread의 slot을 재사용하고, 맞는 slot이 없을 때만 새로 할당한다.
+  if (takeStackSlot(sh, stacksize + tlspages, &np->stack) < 0)
     goto bad;
-  }
-  clearpteu(pgdir, (char *)(sz - 2 * PGSIZE)); // guard page에 접근할 수 없도록 설정
+  top = np->stack.base + np->stack.size;
 
-  // TODO: mthread에 걸린 memory limit은 해당 mthread가 가지는 모든 thread의 sz 합? 혹은 각 스레드마다 개별 mlimit을 가지나?
-  // pid를 기준으로 mlimit을 정해주기 때문에... 하나의 프로세스가 가지는 mlimit이 정해져있고 이는 해당 프로세스의 모든 스레드의 sz 총합일 것 같음
-  // 우선은 그렇게 설정
-  // 그렇게 하자
+  // t9: TLS block은 slot의 가장 위 page들에 두고, stack은 그 아래에서 시작한다
+  if (tlspages > 0)
+  {
+    top -= tlspages * PGSIZE;
+    np->tlsbase = top;
+    np->tlssize = tlssize + sizeof(uint);
+    np->tf->gs = (SEG_UTLS << 3) | DPL_USER;
+  }
+  else
+  {
+    np->tf->gs = 0;
+  }
 
   // arguments setting: 새로운 thread를 실행하기 위한 user stack 설정
   arguments[0] = 0xFFFFFFFF; // return address
   arguments[1] = (uint)arg;  // arguments
-  sp -= 8;                   // 2 * 4
+  sp = top - 8; // 2 * 4
 
-  if (copyout(pgdir, sp, arguments, 8) < 0)
+  if (copyout(sh->pgdir, sp, arguments, 8) < 0 ||
+      (tlspages > 0 && initTLS(sh->pgdir, np->tlsbase, np->tlssize) < 0))
   {
-    deallocuvm(pgdir, sz, sz + 2 * PGSIZE); // copy에 실패하면 deallocate하고 bad로 가서 -1을 return
-    goto bad;
-  }
-
-  // sz가 memory limit을 초과했는지 확인
-  if (mthread->mlimit != 0 && sz > mthread->mlimit)
-  {
-    deallocuvm(pgdir, sz, sz + 2 * PGSIZE); // copy에 실패하면 deallocate하고 bad로 가서 -1을 return
+    acquire(&ptable.lock);
+    putStackSlot(sh, &np->stack);
+    release(&ptable.lock);
     goto bad;
   }
 
-  mthread->sz = sz; // mthread에서 할당된 stack 최상위 값을 가리키도록 함(이후 stack 할당도 차곡차곡...)
-
-  // commit to user image
-  np->sz = sz;
-  np->pgdir = pgdir;
-
   np->tf->eip = (uint)start_routine; // 실행할 명령 주소
   np->tf->esp = sp;                  // stack의 가장 아래 부분
 
@@ -820,6 +1309,18 @@ int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
 
   acquire(&ptable.lock);
 
+  // t7: process가 정리되는 중이면 thread를 만들지 않는다
+  if (sh->exiting)
+  {
+    putStackSlot(sh, &np->stack);
+    release(&ptable.lock);
+    goto bad;
+  }
+
+  // commit to user image
+  np->share = sh;
+  sh->ref++;
+  tidadd(np);
   np->state = RUNNABLE; // scheduler에 의해 스케줄링 될 수 있도록 함
 
   release(&ptable.lock);
@@ -827,6 +1328,8 @@ int thread_create(thread_t *thread, void *(*start_routine)(void *), void *arg)
   return 0;
 
 bad:
+  kfree(np->kstack);
+  np->kstack = 0;
   np->state = UNUSED;
   return -1;
 }
@@ -841,37 +1344,31 @@ void thread_exit(void *retval)
 {
   // 모든 스레드는 이 함수를 통해 종료(시작 함수 끝에 도달하는 경우 고려X)
   struct proc *curproc = myproc();
-  int fd;
 
   curproc->retval = retval;
 
   if (curproc == initproc)
     panic("init exiting");
 
-  // Close all open files.
-  for (fd = 0; fd < NOFILE; fd++)
-  {
-    if (curproc->ofile[fd])
-    {
-      fileclose(curproc->ofile[fd]);
-      curproc->ofile[fd] = 0;
-    }
-  }
-
-  begin_op();
-  iput(curproc->cwd);
-  end_op();
-  curproc->cwd = 0;
-
+  // t5: open file과 cwd는 process의 pshare에 있으므로 닫지 않는다.
+  // pshare의 참조는 thread_join의 cleanThread에서 놓는다.
   acquire(&ptable.lock);
 
-  // Parent or main thread might be sleeping in wait().
-  if (curproc->mthread)
+  // t7: process를 정리하는 thread가 이 thread를 기다리고 있을 수 있다
+  if (curproc->share->exiting)
+    wakeup1(&curproc->share->exiting);
+
+  if (curproc->tid != 0)
   {
-    wakeup1(curproc->mthread);
+    // t4: 이 thread를 join하는 thread만 깨운다
+    zombieadd(curproc->share, curproc);
+    wakeup1(&curproc->tid);
+    if (curproc->share->nanyjoin > 0)
+      wakeup1(curproc->share);
   }
   else
   {
+    // Parent might be sleeping in wait().
     wakeup1(curproc->parent);
   }
 
@@ -892,39 +1389,71 @@ void thread_exit(void *retval)
 int thread_join(thread_t thread, void **retval)
 {
   struct proc *p;
-  int haveThread; // 자식이 있는지 찾는게 아니라, 종료된 스레드가 있는지 찾아야함
   struct proc *curproc = myproc();
 
   acquire(&ptable.lock);
   for (;;)
   {
-    // Scan through table looking for exited threads.
-    haveThread = 0;
-    for (p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    // tid index에서 바로 찾는다. 같은 process의 다른 thread만 join할 수 있다.
+    p = tidlookup(thread);
+    if (p == 0 || p == curproc || p->share != curproc->share || curproc->killed)
     {
-      if (p->tid != thread)
-        continue;
-      haveThread = 1;
-      if (p->state == ZOMBIE)
-      {
-        // Found one.
-        *retval = p->retval;
-        cleanThread(p);
+      release(&ptable.lock);
+      return -1;
+    }
+    if (p->state == ZOMBIE)
+    {
+      *retval = p->retval;
+      putStackSlot(p->share, &p->stack); // 이후 thread_create에서 재사용
+      cleanThread(p);
 
-        release(&ptable.lock);
-        return 0;
-      }
+      release(&ptable.lock);
+      return 0;
     }
 
-    // No point waiting if we don't have any threads.
-    if (!haveThread || curproc->killed)
+    // Wait for the thread to exit. (See wakeup1 call in thread_exit.)
+    sleep(&p->tid, &ptable.lock);
+  }
+}
+
+/**
+ * t4: join any exited thread of the process
+ * 아무 thread나 종료될 때까지 기다렸다가 join한다(thread pool에서 사용).
+ * thread: join된 스레드 id 저장
+ * retval: 스레드가 반환한 값 저장
+ * return: 정상적인 join이면 0, 기다릴 thread가 없으면 -1
+ */
+int thread_join_any(thread_t *thread, void **retval)
+{
+  struct proc *p;
+  struct proc *curproc = myproc();
+  struct pshare *sh = curproc->share;
+
+  acquire(&ptable.lock);
+  for (;;)
+  {
+    if ((p = sh->zombies) != 0)
+    {
+      *thread = p->tid;
+      *retval = p->retval;
+      putStackSlot(sh, &p->stack);
+      cleanThread(p);
+
+      release(&ptable.lock);
+      return 0;
+    }
+
+    // No point waiting if curproc is the only thread left.
+    if (sh->ref <= 1 || curproc->killed)
     {
       release(&ptable.lock);
       return -1;
     }
 
-    // Wait for children to exit.  (See wakeup1 call in proc_exit.)
-    sleep(curproc, &ptable.lock); // DOC: wait-sleep
+    // Woken up by thread_exit and by cleanThread of the other threads.
+    sh->nanyjoin++;
+    sleep(sh, &ptable.lock);
+    sh->nanyjoin--;
   }
 }
 
@@ -44,11 +44,34 @@ enum procstate
   ZOMBIE
 };
 
+// t4: user stack slot of a thread, a guard page followed by the stack
+struct stackslot
+{
+  uint base; // address of the guard page
+  uint size; // bytes of the slot including the guard page
+};
+
+// t5: state shared by all the threads(LWP) of a process
+struct pshare
+{
+  int ref;                    // threads using it, 0 if free
+  uint sz;                    // Size of process memory (bytes), the heap ends here
+  uint stackbase;             // t4: thread stacks take [stackbase, USTACKTOP)
+  pde_t *pgdir;               // Page table
+  int mlimit;                 // t2. memory limit
+  struct file *ofile[NOFILE]; // Open files
+  struct inode *cwd;          // Current directory (like when doing `cd...` in command)
+  struct stackslot freestack[MAXTHREAD]; // t4: slots of joined threads
+  int nfreestack;             // slots in freestack
+  struct proc *zombies;       // exited threads not joined yet
+  int nanyjoin;               // threads sleeping in thread_join_any
+  struct proc *exiting;       // t7: thread taking the others down, see killOtherThreads
+};
+
 // Per-process state
 struct proc
 {
-  uint sz;                    // Size of process memory (bytes)
-  pde_t *pgdir;               // Page table
+  struct pshare *share;       // t5: address space, files and cwd of the process
   char *kstack;               // Bottom of kernel stack for this process
   enum procstate state;       // Process state
   int pid;                    // Process ID
@@ -57,17 +80,25 @@ struct proc
   struct context *context;    // swtch() here to run process
   void *chan;                 // If non-zero, sleeping on chan(channel)
   int killed;                 // If non-zero, have been killed
-  struct file *ofile[NOFILE]; // Open files
-  struct inode *cwd;          // Current directory (like when doing `cd...` in command)
   char name[16];              // Process name (debugging)
 
   int stackpages;             // t1. count of pages for process
-  int mlimit;                 // t2. memory limit
 
   // t4: thread(LWP) 자료 구조
   thread_t tid;               // LWP의 ID(0이면 프로세스)
   struct proc* mthread;       // main thread를 가리키는 변수(thread가 어디서 불렸는지)
   void *retval;               // return value of thread
+  struct stackslot stack;     // user stack slot of the thread, size 0 if none
+  struct proc *tnext;         // next thread in the same tid index chain
+  struct proc *znext, *zprev; // neighbours in the zombies list of the pshare
+
+  struct proc *snext;         // next sleeper in the same sleep queue
+
+  uint rticks;                // t8: timer ticks spent running
+  uint nswitch;               // t8: times switched to by the scheduler
+
+  uint tlsbase;               // t9: TLS block of the thread, base of SEG_UTLS
+  uint tlssize;               // t9: bytes of the TLS block, 0 if none
 };
 
 // Process memory is laid out contiguously, low addresses first:
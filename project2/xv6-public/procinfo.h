@@ -0,0 +1,11 @@
+// t8: snapshot of a thread(LWP), filled in by getprocinfo
+struct procinfo
+{
+  int pid;
+  int tid;            // 0 for the main thread
+  int state;          // enum procstate
+  uint rticks;        // timer ticks it was running on a cpu
+  uint nswitch;       // times the scheduler switched to it
+  uint mem;           // memory of the process (bytes)
+  char name[16];
+};
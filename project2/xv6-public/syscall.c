@@ -13,13 +13,34 @@
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
 
+// t4: End of the user memory holding addr: the text, data and heap
+// end at sz. In the thread stacks it ends at the next guard page,
+// whose PTE_U is cleared, or at USTACKTOP. Return 0 if addr is in
+// neither or on a guard page; the kernel would ignore PTE_U.
+uint
+uvaend(uint addr)
+{
+  struct pshare *sh = myproc()->share;
+  uint va;
+
+  if(addr < sh->sz)
+    return sh->sz;
+  if(addr < sh->stackbase || addr >= USTACKTOP)
+    return 0;
+  // every page of [stackbase, USTACKTOP) is mapped, see takeStackSlot
+  for(va = PGROUNDDOWN(addr); va < USTACKTOP; va += PGSIZE)
+    if(uva2ka(sh->pgdir, (char*)va) == 0)
+      break;
+  return va > addr ? va : 0;
+}
+
 // Fetch the int at addr from the current process.
 int
 fetchint(uint addr, int *ip)
 {
-  struct proc *curproc = myproc();
+  uint end = uvaend(addr);
 
-  if(addr >= curproc->sz || addr+4 > curproc->sz)
+  if(end == 0 || addr+4 > end)
     return -1;
   *ip = *(int*)(addr);
   return 0;
@@ -32,12 +53,12 @@ int
 fetchstr(uint addr, char **pp)
 {
   char *s, *ep;
-  struct proc *curproc = myproc();
+  uint end = uvaend(addr);
 
-  if(addr >= curproc->sz)
+  if(end == 0)
     return -1;
   *pp = (char*)addr;
-  ep = (char*)curproc->sz;
+  ep = (char*)end;
   for(s = *pp; s < ep; s++){
     if(*s == 0)
       return s - *pp;
@@ -59,11 +80,12 @@ int
 argptr(int n, char **pp, int size)
 {
   int i;
-  struct proc *curproc = myproc();
- 
+  uint end;
+
   if(argint(n, &i) < 0)
     return -1;
-  if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
+  end = uvaend((uint)i);
+  if(size < 0 || end == 0 || (uint)i+size > end)
     return -1;
   *pp = (char*)i;
   return 0;
@@ -111,6 +133,12 @@ extern int sys_showProcessList(void);
 extern int sys_thread_create(void);
 extern int sys_thread_exit(void);
 extern int sys_thread_join(void);
+extern int sys_thread_create2(void);
+extern int sys_futex(void);
+extern int sys_thread_join_any(void);
+extern int sys_getncpu(void);
+extern int sys_getprocinfo(void);
+extern int sys_thread_create3(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -142,6 +170,12 @@ static int (*syscalls[])(void) = {
 [SYS_thread_create] sys_thread_create,
 [SYS_thread_exit] sys_thread_exit,
 [SYS_thread_join] sys_thread_join,
+[SYS_thread_create2] sys_thread_create2,
+[SYS_futex] sys_futex,
+[SYS_thread_join_any] sys_thread_join_any,
+[SYS_getncpu] sys_getncpu,
+[SYS_getprocinfo] sys_getprocinfo,
+[SYS_thread_create3] sys_thread_create3,
 };
 
 void
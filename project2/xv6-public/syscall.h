@@ -27,4 +27,10 @@
 #define SYS_showProcessList 24
 #define SYS_thread_create 25
 #define SYS_thread_exit 26
-#define SYS_thread_join 27
\ No newline at end of file
+#define SYS_thread_join 27
+#define SYS_thread_create2 28
+#define SYS_futex 29
+#define SYS_thread_join_any 30
+#define SYS_getncpu 31
+#define SYS_getprocinfo 32
+#define SYS_thread_create3 33
\ No newline at end of file
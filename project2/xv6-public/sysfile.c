@@ -26,7 +26,7 @@ argfd(int n, int *pfd, struct file **pf)
 
   if (argint(n, &fd) < 0)
     return -1;
-  if (fd < 0 || fd >= NOFILE || (f = myproc()->ofile[fd]) == 0)
+  if (fd < 0 || fd >= NOFILE || (f = myproc()->share->ofile[fd]) == 0)
     return -1;
   if (pfd)
     *pfd = fd;
@@ -45,9 +45,9 @@ fdalloc(struct file *f)
 
   for (fd = 0; fd < NOFILE; fd++)
   {
-    if (curproc->ofile[fd] == 0)
+    if (curproc->share->ofile[fd] == 0)
     {
-      curproc->ofile[fd] = f;
+      curproc->share->ofile[fd] = f;
       return fd;
     }
   }
@@ -96,7 +96,7 @@ int sys_close(void)
 
   if (argfd(0, &fd, &f) < 0)
     return -1;
-  myproc()->ofile[fd] = 0;
+  myproc()->share->ofile[fd] = 0;
   fileclose(f);
   return 0;
 }
@@ -398,9 +398,9 @@ int sys_chdir(void)
     return -1;
   }
   iunlock(ip);
-  iput(curproc->cwd);
+  iput(curproc->share->cwd);
   end_op();
-  curproc->cwd = ip;
+  curproc->share->cwd = ip;
   return 0;
 }
 
@@ -446,7 +446,7 @@ int sys_pipe(void)
   if ((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0)
   {
     if (fd0 >= 0)
-      myproc()->ofile[fd0] = 0;
+      myproc()->share->ofile[fd0] = 0;
     fileclose(rf);
     fileclose(wf);
     return -1;
@@ -6,6 +6,7 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "procinfo.h"
 
 int sys_fork(void)
 {
@@ -45,17 +46,8 @@ int sys_sbrk(void)
   if (argint(0, &n) < 0)
     return -1;
 
-  struct proc *p = myproc();
-  if (p->tid == 0 || !(p->mthread)) // sub thread가 없음, 즉 본인이 main thread(process)
-  {
-    addr = p->sz;
-  }
-  else
-  {
-    addr = p->mthread->sz; // 본인이 sub thread라서, main thread의 sz(total sz)를 찾아줌
-  }
-  
-  if (growproc(n) < 0)
+  // t4: growproc이 old sz를 돌려주므로 동시에 sbrk한 thread들이 같은 addr를 받지 않는다
+  if ((addr = growproc(n)) < 0)
     return -1;
   return addr;
 }
@@ -125,7 +117,59 @@ int sys_thread_create(void)
   if (argptr(2, (char **)&arg, sizeof arg) < 0)
     return -1;
 
-  return thread_create((thread_t *)thread, (void *)start_routine, (void *)arg);
+  return thread_create((thread_t *)thread, (void *)start_routine, (void *)arg, 1, 0);
+}
+
+// t4: thread_create with stacksize pages of user stack
+int sys_thread_create2(void)
+{
+  thread_t *thread;
+  int stacksize;
+  void *(*start_routine)(void *);
+  void *arg;
+
+  if (argptr(0, (char **)&thread, sizeof(*thread)) < 0)
+    return -1;
+  if (argptr(1, (char **)&start_routine, sizeof start_routine) < 0)
+    return -1;
+  if (argptr(2, (char **)&arg, sizeof arg) < 0)
+    return -1;
+  if (argint(3, &stacksize) < 0)
+    return -1;
+
+  // exec2와 같이 stack용 page 개수는 1이상 100이하의 정수
+  if (stacksize < 1 || stacksize > 100)
+    return -1;
+
+  return thread_create(thread, (void *)start_routine, (void *)arg, stacksize, 0);
+}
+
+// t9: thread_create2 with a TLS block of tlssize bytes, reached through %gs
+int sys_thread_create3(void)
+{
+  thread_t *thread;
+  int stacksize, tlssize;
+  void *(*start_routine)(void *);
+  void *arg;
+
+  if (argptr(0, (char **)&thread, sizeof(*thread)) < 0)
+    return -1;
+  if (argptr(1, (char **)&start_routine, sizeof start_routine) < 0)
+    return -1;
+  if (argptr(2, (char **)&arg, sizeof arg) < 0)
+    return -1;
+  if (argint(3, &stacksize) < 0)
+    return -1;
+  if (argint(4, &tlssize) < 0)
+    return -1;
+
+  if (stacksize < 1 || stacksize > 100)
+    return -1;
+  // SEG_UTLS는 byte 단위 segment이므로 1MB보다 작아야 하고, stack slot에 들어가야 한다
+  if (tlssize < 0 || tlssize > MAXTLS)
+    return -1;
+
+  return thread_create(thread, (void *)start_routine, (void *)arg, stacksize, tlssize);
 }
 
 int
@@ -149,3 +193,50 @@ sys_thread_join(void){
   }
   return thread_join((thread_t)thread, (void **)retval);
 }
+
+// t4: thread_join of whichever thread exits first
+int sys_thread_join_any(void)
+{
+  thread_t *thread;
+  void **retval;
+
+  if (argptr(0, (char **)&thread, sizeof(*thread)) < 0)
+    return -1;
+  if (argptr(1, (char **)&retval, sizeof(*retval)) < 0)
+    return -1;
+  return thread_join_any(thread, retval);
+}
+
+// t6: futex(addr, op, val, addr2), addr2 is only used by FUTEX_REQUEUE
+int sys_futex(void)
+{
+  int addr, op, val, addr2;
+
+  if (argint(0, &addr) < 0 || argint(1, &op) < 0)
+    return -1;
+  if (argint(2, &val) < 0 || argint(3, &addr2) < 0)
+    return -1;
+
+  return futex((int *)addr, op, val, (int *)addr2);
+}
+
+// number of cpus, for user programs sizing their thread pools
+int sys_getncpu(void)
+{
+  return ncpu;
+}
+
+// t8: getprocinfo(info, max), a snapshot of the threads for pmanager top
+int sys_getprocinfo(void)
+{
+  struct procinfo *info;
+  int max;
+
+  if (argint(1, &max) < 0 || max < 0)
+    return -1;
+  if (max > NPROC)
+    max = NPROC;
+  if (argptr(0, (char **)&info, max * sizeof(*info)) < 0)
+    return -1;
+  return getprocinfo(info, max);
+}
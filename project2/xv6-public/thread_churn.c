@@ -0,0 +1,73 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 4
+#define NUM_ROUND 100
+
+// uses most of a 2 page stack
+void *thread_big(void *arg)
+{
+  char buf[6000];
+  int i;
+
+  for (i = 0; i < sizeof(buf); i++)
+    buf[i] = (char)i;
+  thread_exit((void *)(buf[(int)arg] + 1));
+  return 0;
+}
+
+void *thread_small(void *arg)
+{
+  thread_exit(arg);
+  return 0;
+}
+
+thread_t thread[NUM_THREAD];
+
+int main(int argc, char *argv[])
+{
+  int i, round;
+  uint sz = 0;
+  void *retval;
+
+  printf(1, "Thread churn test start\n");
+  for (round = 0; round < NUM_ROUND; round++)
+  {
+    for (i = 0; i < NUM_THREAD; i++)
+    {
+      // mix stack sizes so slots of both sizes are recycled
+      int r = (i % 2 == 0) ? thread_create2(&thread[i], thread_big, (void *)i, 2)
+                           : thread_create(&thread[i], thread_small, (void *)i);
+      if (r != 0)
+      {
+        printf(1, "round %d: thread_create failed\n", round);
+        exit();
+      }
+    }
+    for (i = 0; i < NUM_THREAD; i++)
+    {
+      if (thread_join(thread[i], &retval) != 0)
+      {
+        printf(1, "round %d: thread_join failed\n", round);
+        exit();
+      }
+      if ((int)retval != ((i % 2 == 0) ? i + 1 : i))
+      {
+        printf(1, "round %d: thread %d returned %d\n", round, i, (int)retval);
+        exit();
+      }
+    }
+
+    // joined stacks are reused, memory stays at the size of the first round
+    if (round == 0)
+      sz = (uint)sbrk(0);
+    else if ((uint)sbrk(0) != sz)
+    {
+      printf(1, "round %d: memory grew from %d to %d\n", round, sz, (uint)sbrk(0));
+      exit();
+    }
+  }
+  printf(1, "Thread churn test ok, memory %d\n", sz);
+  exit();
+}
@@ -0,0 +1,62 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 4
+#define NUM_ROUND 10
+
+// a thread other than the main one exits the whole process
+void *thread_main(void *arg)
+{
+  if ((int)arg == 0)
+  {
+    sleep(5);
+    exit();
+  }
+  sleep(1000);
+  return 0;
+}
+
+thread_t thread[NUM_THREAD];
+
+int main(int argc, char *argv[])
+{
+  int i, round, pid, r, failed = 0;
+
+  printf(1, "Thread exit wait test start\n");
+  for (round = 0; round < NUM_ROUND; round++)
+  {
+    pid = fork();
+    if (pid < 0)
+    {
+      printf(1, "round %d: fork failed\n", round);
+      exit();
+    }
+    if (pid == 0)
+    {
+      for (i = 0; i < NUM_THREAD; i++)
+        thread_create(&thread[i], thread_main, (void *)i);
+      sleep(1000);
+      printf(1, "round %d: main thread was not killed\n", round);
+      exit();
+    }
+
+    // the process must be reaped exactly once, under its own pid
+    if ((r = wait()) != pid)
+    {
+      printf(1, "round %d: wait returned %d, expected %d\n", round, r, pid);
+      failed = 1;
+    }
+    if ((r = wait()) != -1)
+    {
+      printf(1, "round %d: wait returned %d again\n", round, r);
+      failed = 1;
+    }
+  }
+
+  if (failed)
+    printf(1, "Thread exit wait test failed\n");
+  else
+    printf(1, "Thread exit wait test ok\n");
+  exit();
+}
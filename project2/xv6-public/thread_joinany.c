@@ -0,0 +1,73 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 8
+#define NUM_ROUND 20
+
+// threads exit in a different order than they were created
+void *thread_main(void *arg)
+{
+  sleep((NUM_THREAD - (int)arg) % 3);
+  thread_exit((void *)((int)arg * 10));
+  return 0;
+}
+
+thread_t thread[NUM_THREAD];
+
+int main(int argc, char *argv[])
+{
+  int i, j, round, seen[NUM_THREAD];
+  thread_t tid;
+  void *retval;
+
+  printf(1, "Thread join any test start\n");
+  for (round = 0; round < NUM_ROUND; round++)
+  {
+    for (i = 0; i < NUM_THREAD; i++)
+    {
+      if (thread_create(&thread[i], thread_main, (void *)i) != 0)
+      {
+        printf(1, "round %d: thread_create failed\n", round);
+        exit();
+      }
+      seen[i] = 0;
+    }
+
+    // join the first half by tid, reap the rest as they exit
+    for (i = 0; i < NUM_THREAD / 2; i++)
+    {
+      if (thread_join(thread[i], &retval) != 0 || (int)retval != i * 10)
+      {
+        printf(1, "round %d: thread_join of thread %d failed\n", round, i);
+        exit();
+      }
+      seen[i] = 1;
+    }
+    for (i = NUM_THREAD / 2; i < NUM_THREAD; i++)
+    {
+      if (thread_join_any(&tid, &retval) != 0)
+      {
+        printf(1, "round %d: thread_join_any failed\n", round);
+        exit();
+      }
+      for (j = 0; j < NUM_THREAD && thread[j] != tid; j++)
+        ;
+      if (j == NUM_THREAD || seen[j] || (int)retval != j * 10)
+      {
+        printf(1, "round %d: thread_join_any returned tid %d, %d\n", round, tid, (int)retval);
+        exit();
+      }
+      seen[j] = 1;
+    }
+
+    // nothing is left to join
+    if (thread_join_any(&tid, &retval) != -1 || thread_join(thread[0], &retval) != -1)
+    {
+      printf(1, "round %d: joined a thread twice\n", round);
+      exit();
+    }
+  }
+  printf(1, "Thread join any test ok\n");
+  exit();
+}
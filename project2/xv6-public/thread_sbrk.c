@@ -0,0 +1,73 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NUM_THREAD 4
+#define NUM_GROW 64
+
+char *region[NUM_THREAD][NUM_GROW];
+
+// grow the heap from all threads at once, tagging each new page
+void *thread_main(void *arg)
+{
+  int t = (int)arg;
+  int i;
+  char *p;
+
+  for (i = 0; i < NUM_GROW; i++)
+  {
+    if ((p = sbrk(4096)) == (char *)-1)
+      thread_exit((void *)-1);
+    memset(p, t + 1, 4096);
+    region[t][i] = p;
+  }
+  thread_exit(0);
+  return 0;
+}
+
+thread_t thread[NUM_THREAD];
+
+int main(int argc, char *argv[])
+{
+  int t, i, k;
+  void *retval;
+  char *p;
+
+  printf(1, "Thread sbrk test start\n");
+  for (t = 0; t < NUM_THREAD; t++)
+  {
+    if (thread_create(&thread[t], thread_main, (void *)t) != 0)
+    {
+      printf(1, "thread_create failed\n");
+      exit();
+    }
+  }
+  for (t = 0; t < NUM_THREAD; t++)
+  {
+    if (thread_join(thread[t], &retval) != 0 || retval != 0)
+    {
+      printf(1, "thread %d: sbrk failed\n", t);
+      exit();
+    }
+  }
+
+  // every page got to exactly one thread and kept its tag;
+  // thread stacks live apart from the heap and never end up in between
+  for (t = 0; t < NUM_THREAD; t++)
+  {
+    for (i = 0; i < NUM_GROW; i++)
+    {
+      p = region[t][i];
+      for (k = 0; k < 4096; k++)
+      {
+        if (p[k] != t + 1)
+        {
+          printf(1, "thread %d: page %x overwritten\n", t, p);
+          exit();
+        }
+      }
+    }
+  }
+  printf(1, "Thread sbrk test ok\n");
+  exit();
+}
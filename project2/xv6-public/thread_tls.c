@@ -0,0 +1,85 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "utls.h"
+
+#define NUM_THREAD 8
+#define NUM_ROUND 5
+#define NUM_ITER 1000
+
+struct counter
+{
+  uint id;
+  uint count;
+  char pad[100];
+  uint last; // beyond the first 100 bytes, still inside the block
+};
+
+// every thread bumps counters kept in its own TLS block; threads run
+// at the same time, so any sharing of blocks shows up as wrong counts
+void *thread_main(void *arg)
+{
+  struct counter *c = TLS_VAR(struct counter, 0);
+  int i;
+
+  if (c->id != 0 || c->count != 0 || c->last != 0 || tls_get(0) != 0)
+  {
+    printf(1, "thread %d: TLS block not zeroed\n", (int)arg);
+    thread_exit((void *)-1);
+  }
+  c->id = (uint)arg;
+  for (i = 0; i < NUM_ITER; i++)
+  {
+    tls_set(4, tls_get(4) + 1);
+    c->last = c->count * 2;
+    if (i % 100 == 0)
+      sleep(1);
+  }
+  if (c->id != (uint)arg || c->count != NUM_ITER || c->last != (NUM_ITER - 1) * 2)
+  {
+    printf(1, "thread %d: TLS block changed under it\n", (int)arg);
+    thread_exit((void *)-1);
+  }
+  thread_exit((void *)0);
+  return 0;
+}
+
+thread_t thread[NUM_THREAD];
+
+int main(int argc, char *argv[])
+{
+  int i, round, failed = 0;
+  void *retval;
+
+  printf(1, "Thread TLS test start\n");
+  for (round = 0; round < NUM_ROUND && !failed; round++)
+  {
+    for (i = 0; i < NUM_THREAD; i++)
+    {
+      if (thread_create3(&thread[i], thread_main, (void *)(i + 1), 1, sizeof(struct counter)) != 0)
+      {
+        printf(1, "round %d: thread_create3 failed\n", round);
+        exit();
+      }
+    }
+    for (i = 0; i < NUM_THREAD; i++)
+    {
+      if (thread_join(thread[i], &retval) != 0 || retval != 0)
+        failed = 1;
+    }
+  }
+
+  if (thread_create3(&thread[0], thread_main, 0, 1, MAXTLS + 1) == 0)
+  {
+    printf(1, "thread_create3 accepted a TLS block that is too large\n");
+    failed = 1;
+    thread_join(thread[0], &retval);
+  }
+
+  if (failed)
+    printf(1, "Thread TLS test failed\n");
+  else
+    printf(1, "Thread TLS test ok\n");
+  exit();
+}
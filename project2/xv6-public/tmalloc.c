@@ -0,0 +1,184 @@
+// Thread-caching memory allocator.
+//
+// Small blocks come in size classes of 16 to 2048 bytes, header
+// included. Each cache keeps a free list per class; a cache is locked
+// by at most one thread at a time, so its lock almost never sleeps.
+// Caches refill from and give back to the central heap in batches,
+// which is the only place threads contend. The central heap carves
+// new blocks from chunks it gets from sbrk.
+//
+// There is no per-thread storage, so a thread picks its cache by the
+// page its stack pointer is on: threads have separate stacks and
+// mostly land on different caches. If that cache is busy the next
+// free one is taken.
+//
+// Bigger blocks go to malloc under the central lock, so programs that
+// use tmalloc must not call malloc and free from several threads.
+
+#include "types.h"
+#include "user.h"
+#include "uthread.h"
+#include "tmalloc.h"
+
+#define NCLASS 8           // 16 << class bytes, header included
+#define MINSHIFT 4
+#define NCACHE 8
+#define BATCH 32           // blocks moved between a cache and the heap at once
+#define CACHEMAX (2 * BATCH)
+#define CHUNK (64 * 1024)  // bytes the heap gets from sbrk at once
+#define LARGE NCLASS       // class of blocks from malloc
+
+// Header in front of every block. Keeps the block 8 byte aligned.
+struct header {
+  uint class;
+  uint pad;
+};
+
+struct block {
+  struct block *next;
+};
+
+struct cache {
+  thread_mutex_t lock;
+  struct block *free[NCLASS];
+  int n[NCLASS];
+};
+
+struct cache caches[NCACHE];
+
+struct {
+  thread_mutex_t lock;
+  struct block *free[NCLASS];
+  char *next, *end;        // rest of the last chunk
+} heap;
+
+static struct cache*
+lockcache(void)
+{
+  uint sp = (uint)&sp;
+  int c, i;
+
+  c = ((sp >> 12) * 2654435761U) >> 29;  // NCACHE == 8
+  for(i = 0; i < NCACHE; i++){
+    if(thread_mutex_trylock(&caches[(c + i) % NCACHE].lock) == 0)
+      return &caches[(c + i) % NCACHE];
+  }
+  thread_mutex_lock(&caches[c].lock);
+  return &caches[c];
+}
+
+// Move up to BATCH blocks of class from the heap to cache c.
+// Return the number moved.
+static int
+refill(struct cache *c, int class)
+{
+  uint size = 16 << class;
+  struct block *b;
+  int n;
+
+  thread_mutex_lock(&heap.lock);
+  for(n = 0; n < BATCH; n++){
+    if((b = heap.free[class]) != 0)
+      heap.free[class] = b->next;
+    else {
+      if(heap.end - heap.next < size){
+        // the rest of the old chunk is too small for this class, drop it
+        if((heap.next = sbrk(CHUNK)) == (char*)-1){
+          heap.next = heap.end = 0;
+          break;
+        }
+        heap.end = heap.next + CHUNK;
+      }
+      b = (struct block*)heap.next;
+      heap.next += size;
+    }
+    b->next = c->free[class];
+    c->free[class] = b;
+  }
+  thread_mutex_unlock(&heap.lock);
+  c->n[class] += n;
+  return n;
+}
+
+// Give BATCH blocks of class of cache c back to the heap.
+static void
+drain(struct cache *c, int class)
+{
+  struct block *first, *last;
+  int n;
+
+  first = last = c->free[class];
+  for(n = 1; n < BATCH; n++)
+    last = last->next;
+  c->free[class] = last->next;
+  c->n[class] -= BATCH;
+
+  thread_mutex_lock(&heap.lock);
+  last->next = heap.free[class];
+  heap.free[class] = first;
+  thread_mutex_unlock(&heap.lock);
+}
+
+void*
+tmalloc(uint nbytes)
+{
+  struct header *h;
+  struct cache *c;
+  struct block *b;
+  int class;
+
+  nbytes += sizeof(struct header);
+  for(class = 0; class < NCLASS && (16 << class) < nbytes; class++)
+    ;
+  if(class == NCLASS){
+    thread_mutex_lock(&heap.lock);
+    h = malloc(nbytes);
+    thread_mutex_unlock(&heap.lock);
+    if(h == 0)
+      return 0;
+    h->class = LARGE;
+    return h + 1;
+  }
+
+  c = lockcache();
+  if(c->free[class] == 0 && refill(c, class) == 0){
+    thread_mutex_unlock(&c->lock);
+    return 0;
+  }
+  b = c->free[class];
+  c->free[class] = b->next;
+  c->n[class]--;
+  thread_mutex_unlock(&c->lock);
+
+  h = (struct header*)b;
+  h->class = class;
+  return h + 1;
+}
+
+void
+tfree(void *ap)
+{
+  struct header *h;
+  struct cache *c;
+  struct block *b;
+  int class;
+
+  if(ap == 0)
+    return;
+  h = (struct header*)ap - 1;
+  class = h->class;
+  if(class == LARGE){
+    thread_mutex_lock(&heap.lock);
+    free(h);
+    thread_mutex_unlock(&heap.lock);
+    return;
+  }
+
+  b = (struct block*)h;
+  c = lockcache();
+  b->next = c->free[class];
+  c->free[class] = b;
+  if(++c->n[class] > CACHEMAX)
+    drain(c, class);
+  thread_mutex_unlock(&c->lock);
+}
@@ -0,0 +1,6 @@
+// Thread-caching allocator for programs with threads(LWP).
+// Include after user.h.
+
+// tmalloc.c
+void* tmalloc(uint);
+void tfree(void*);
@@ -0,0 +1,102 @@
+// Scaling benchmark of uthreadpool: a parallel for and a parallel
+// reduce over the same range, with 1 worker up to one worker per cpu.
+// Run with different CPUS (make qemu CPUS=4) to see the speedup.
+//
+// usage: tpool_bench [n]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "uthreadpool.h"
+
+#define NUM_ELEM 4096
+#define NUM_WORK 2000  // work per element
+#define GRAIN 16
+
+int n;
+int out[NUM_ELEM];
+
+int f(int i)
+{
+  volatile int x = i;
+  int k;
+
+  for (k = 0; k < NUM_WORK; k++)
+    x = x * 7 + 3;
+  return x & 0xff;
+}
+
+void for_body(void *arg, int lo, int hi)
+{
+  int i;
+
+  for (i = lo; i < hi; i++)
+    out[i] = f(i);
+}
+
+int reduce_body(void *arg, int lo, int hi)
+{
+  int i, sum = 0;
+
+  for (i = lo; i < hi; i++)
+    sum += f(i);
+  return sum;
+}
+
+int main(int argc, char *argv[])
+{
+  int ncpu, nworker, i, start, tfor, treduce, sum, expect;
+  int base = 0;
+
+  n = NUM_ELEM;
+  if (argc > 1)
+    n = atoi(argv[1]);
+  if (n < 1 || n > NUM_ELEM)
+    n = NUM_ELEM;
+  ncpu = getncpu();
+  printf(1, "tpool bench: %d cpus, %d elements\n", ncpu, n);
+
+  expect = 0;
+  for (i = 0; i < n; i++)
+    expect += f(i);
+
+  for (nworker = 1; nworker <= ncpu && nworker <= MAXWORKER; nworker++)
+  {
+    if (uthreadpool_init(nworker) != 0)
+    {
+      printf(1, "tpool_bench: uthreadpool_init %d failed\n", nworker);
+      exit();
+    }
+    memset(out, 0, sizeof(out));
+    start = uptime();
+    uthreadpool_for(0, n, GRAIN, for_body, 0);
+    tfor = uptime() - start;
+    for (i = 0; i < n; i++)
+    {
+      if (out[i] != f(i))
+      {
+        printf(1, "tpool_bench: for missed element %d\n", i);
+        exit();
+      }
+    }
+
+    start = uptime();
+    sum = uthreadpool_reduce(0, n, GRAIN, reduce_body, 0);
+    treduce = uptime() - start;
+    uthreadpool_exit();
+    if (sum != expect)
+    {
+      printf(1, "tpool_bench: reduce %d, expected %d\n", sum, expect);
+      exit();
+    }
+
+    if (nworker == 1)
+      base = tfor + treduce;
+    printf(1, "%d workers: for %d ticks, reduce %d ticks", nworker, tfor, treduce);
+    if (base > 0 && tfor + treduce > 0)
+      printf(1, ", speedup %d.%d", base / (tfor + treduce), base * 10 / (tfor + treduce) % 10);
+    printf(1, "\n");
+  }
+  printf(1, "tpool bench ok\n");
+  exit();
+}
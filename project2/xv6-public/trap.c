@@ -54,6 +54,9 @@ trap(struct trapframe *tf)
       wakeup(&ticks);
       release(&tickslock);
     }
+    // t8: charge the tick to the thread running on this cpu
+    if(myproc() && myproc()->state == RUNNING)
+      myproc()->rticks++;
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -71,6 +74,10 @@ trap(struct trapframe *tf)
     uartintr();
     lapiceoi();
     break;
+  case T_IRQ0 + IRQ_KICK:
+    // nothing to do, a killed process exits on the way back to user space
+    lapiceoi();
+    break;
   case T_IRQ0 + 7:
   case T_IRQ0 + IRQ_SPURIOUS:
     cprintf("cpu%d: spurious interrupt at %x:%x\n",
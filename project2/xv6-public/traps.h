@@ -34,5 +34,6 @@
 #define IRQ_COM1         4
 #define IRQ_IDE         14
 #define IRQ_ERROR       19
+#define IRQ_KICK        20  // t7: IPI making a cpu check its process for kill
 #define IRQ_SPURIOUS    31
 
@@ -0,0 +1,44 @@
+// Atomic operations on user memory for the thread libraries.
+
+static inline int
+xchg(volatile int *addr, int newval)
+{
+  int result;
+
+  asm volatile("lock; xchgl %0, %1" :
+               "+m" (*addr), "=a" (result) :
+               "1" (newval) :
+               "cc", "memory");
+  return result;
+}
+
+// If *addr is old, store new. Return the value *addr had.
+static inline int
+cmpxchg(volatile int *addr, int old, int new)
+{
+  int result;
+
+  asm volatile("lock; cmpxchgl %2, %1" :
+               "=a" (result), "+m" (*addr) :
+               "r" (new), "0" (old) :
+               "cc", "memory");
+  return result;
+}
+
+// Add n to *addr. Return the value *addr had.
+static inline int
+fetchadd(volatile int *addr, int n)
+{
+  asm volatile("lock; xaddl %0, %1" :
+               "+r" (n), "+m" (*addr) :
+               :
+               "cc", "memory");
+  return n;
+}
+
+// Full memory barrier, orders earlier stores before later loads.
+static inline void
+mfence(void)
+{
+  asm volatile("mfence" : : : "memory");
+}
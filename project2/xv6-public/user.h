@@ -1,4 +1,5 @@
 struct stat;
+struct procinfo;
 struct rtcdate;
 
 // system calls
@@ -29,6 +30,12 @@ void showProcessList(void);
 int thread_create(thread_t *, void *(void *), void *);
 void thread_exit(void *retval);
 int thread_join(thread_t thread, void **retval);
+int thread_create2(thread_t *, void *(void *), void *, int stacksize);
+int futex(int *addr, int op, int val, int *addr2);
+int thread_join_any(thread_t *thread, void **retval);
+int getncpu(void);
+int getprocinfo(struct procinfo*, int max);
+int thread_create3(thread_t *, void *(void *), void *, int stacksize, int tlssize);
 
 // ulib.c
 int stat(const char*, struct stat*);
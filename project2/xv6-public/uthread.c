@@ -0,0 +1,171 @@
+// t6: user-level mutex, condition variable, barrier and rwlock.
+// The fast paths are atomic instructions on user memory; a thread
+// only enters the kernel to sleep in futex when it has to wait, or
+// to wake up others when there are waiters.
+
+#include "types.h"
+#include "user.h"
+#include "futex.h"
+#include "uatomic.h"
+#include "uthread.h"
+
+void
+thread_mutex_init(thread_mutex_t *m)
+{
+  m->state = 0;
+}
+
+void
+thread_mutex_lock(thread_mutex_t *m)
+{
+  int c;
+
+  if((c = cmpxchg(&m->state, 0, 1)) == 0)
+    return;
+  // contended: mark waiters and sleep until the holder hands over
+  if(c != 2)
+    c = xchg(&m->state, 2);
+  while(c != 0){
+    futex((int*)&m->state, FUTEX_WAIT, 2, 0);
+    c = xchg(&m->state, 2);
+  }
+}
+
+// Return 0 if the mutex was taken, -1 if it is held.
+int
+thread_mutex_trylock(thread_mutex_t *m)
+{
+  return cmpxchg(&m->state, 0, 1) == 0 ? 0 : -1;
+}
+
+void
+thread_mutex_unlock(thread_mutex_t *m)
+{
+  if(xchg(&m->state, 0) == 2)
+    futex((int*)&m->state, FUTEX_WAKE, 1, 0);
+}
+
+void
+thread_cond_init(thread_cond_t *cv)
+{
+  cv->seq = 0;
+  cv->m = 0;
+}
+
+// Wakeups may be spurious, callers recheck their condition.
+void
+thread_cond_wait(thread_cond_t *cv, thread_mutex_t *m)
+{
+  int seq;
+
+  cv->m = m;
+  seq = cv->seq;
+  thread_mutex_unlock(m);
+  futex((int*)&cv->seq, FUTEX_WAIT, seq, 0);
+  // broadcast may have moved other waiters onto the mutex, so take it
+  // as contended to make sure they are woken up in turn
+  while(xchg(&m->state, 2) != 0)
+    futex((int*)&m->state, FUTEX_WAIT, 2, 0);
+}
+
+void
+thread_cond_signal(thread_cond_t *cv)
+{
+  fetchadd(&cv->seq, 1);
+  futex((int*)&cv->seq, FUTEX_WAKE, 1, 0);
+}
+
+// Wake up one waiter and move the others to the mutex, rather than
+// waking them all up to fight over it. The caller must hold the mutex
+// of the waiters, which is marked contended so that unlocking it wakes
+// up the moved waiters one by one.
+void
+thread_cond_broadcast(thread_cond_t *cv)
+{
+  fetchadd(&cv->seq, 1);
+  if(cv->m == 0)
+    return;
+  cv->m->state = 2;
+  futex((int*)&cv->seq, FUTEX_REQUEUE, 1, (int*)&cv->m->state);
+}
+
+void
+thread_barrier_init(thread_barrier_t *b, int count)
+{
+  thread_mutex_init(&b->m);
+  thread_cond_init(&b->cv);
+  b->count = count;
+  b->waiting = 0;
+  b->round = 0;
+}
+
+// Wait until count threads have arrived. Return 1 in the last thread
+// to arrive, 0 in the others.
+int
+thread_barrier_wait(thread_barrier_t *b)
+{
+  int round;
+
+  thread_mutex_lock(&b->m);
+  if(++b->waiting == b->count){
+    b->waiting = 0;
+    b->round++;
+    thread_cond_broadcast(&b->cv);
+    thread_mutex_unlock(&b->m);
+    return 1;
+  }
+  round = b->round;
+  while(round == b->round)
+    thread_cond_wait(&b->cv, &b->m);
+  thread_mutex_unlock(&b->m);
+  return 0;
+}
+
+void
+thread_rwlock_init(thread_rwlock_t *rw)
+{
+  thread_mutex_init(&rw->m);
+  thread_cond_init(&rw->readable);
+  thread_cond_init(&rw->writable);
+  rw->readers = 0;
+  rw->writer = 0;
+  rw->wwaiting = 0;
+}
+
+void
+thread_rwlock_rdlock(thread_rwlock_t *rw)
+{
+  thread_mutex_lock(&rw->m);
+  while(rw->writer || rw->wwaiting)
+    thread_cond_wait(&rw->readable, &rw->m);
+  rw->readers++;
+  thread_mutex_unlock(&rw->m);
+}
+
+void
+thread_rwlock_wrlock(thread_rwlock_t *rw)
+{
+  thread_mutex_lock(&rw->m);
+  rw->wwaiting++;
+  while(rw->writer || rw->readers)
+    thread_cond_wait(&rw->writable, &rw->m);
+  rw->wwaiting--;
+  rw->writer = 1;
+  thread_mutex_unlock(&rw->m);
+}
+
+void
+thread_rwlock_unlock(thread_rwlock_t *rw)
+{
+  thread_mutex_lock(&rw->m);
+  if(rw->writer)
+    rw->writer = 0;
+  else
+    rw->readers--;
+  if(rw->wwaiting){
+    if(rw->readers == 0)
+      thread_cond_signal(&rw->writable);
+  } else
+    thread_cond_broadcast(&rw->readable);
+  thread_mutex_unlock(&rw->m);
+}
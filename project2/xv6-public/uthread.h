@@ -0,0 +1,44 @@
+// t6: user-level synchronization for threads(LWP), built on futex.
+// Include after user.h.
+
+typedef struct {
+  volatile int state;   // 0 unlocked, 1 locked, 2 locked with waiters
+} thread_mutex_t;
+
+typedef struct {
+  volatile int seq;     // bumped by every signal and broadcast
+  thread_mutex_t *m;    // mutex of the waiters, for broadcast to requeue on
+} thread_cond_t;
+
+typedef struct {
+  thread_mutex_t m;
+  thread_cond_t cv;
+  int count;            // threads to wait for
+  int waiting;          // threads arrived in this round
+  int round;
+} thread_barrier_t;
+
+typedef struct {
+  thread_mutex_t m;
+  thread_cond_t readable;
+  thread_cond_t writable;
+  int readers;          // readers holding the lock
+  int writer;           // non-zero if a writer holds the lock
+  int wwaiting;         // writers waiting, they go before new readers
+} thread_rwlock_t;
+
+// uthread.c
+void thread_mutex_init(thread_mutex_t*);
+void thread_mutex_lock(thread_mutex_t*);
+int thread_mutex_trylock(thread_mutex_t*);
+void thread_mutex_unlock(thread_mutex_t*);
+void thread_cond_init(thread_cond_t*);
+void thread_cond_wait(thread_cond_t*, thread_mutex_t*);
+void thread_cond_signal(thread_cond_t*);
+void thread_cond_broadcast(thread_cond_t*);
+void thread_barrier_init(thread_barrier_t*, int count);
+int thread_barrier_wait(thread_barrier_t*);
+void thread_rwlock_init(thread_rwlock_t*);
+void thread_rwlock_rdlock(thread_rwlock_t*);
+void thread_rwlock_wrlock(thread_rwlock_t*);
+void thread_rwlock_unlock(thread_rwlock_t*);
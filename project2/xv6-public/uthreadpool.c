@@ -0,0 +1,333 @@
+// Thread pool of worker LWPs with work-stealing deques.
+//
+// Each worker owns a Chase-Lev deque. It pushes and pops tasks at the
+// bottom end of its own deque, while idle workers steal from the top
+// end of the others. Tasks from threads outside the pool go through a
+// shared inject queue. A worker that finds no task anywhere parks in
+// futex until a new task is pushed, so idle workers cost no cpu.
+//
+// There is a single pool per process. Tasks must not wait for other
+// tasks; wait only from outside the pool, with uthreadpool_wait.
+
+#include "types.h"
+#include "user.h"
+#include "futex.h"
+#include "uatomic.h"
+#include "uthread.h"
+#include "uthreadpool.h"
+
+#define DEQUESIZE 256        // tasks per deque, a power of 2
+#define INJECTSIZE 64        // tasks in the inject queue
+#define NSPIN 64             // rounds of looking for work before parking
+#define WORKERSTACK 2        // pages of stack of a worker
+
+struct task {
+  uthreadfn fn;
+  void *arg;
+  int lo, hi, grain;
+  struct uthreadgroup *group;
+};
+
+struct worker {
+  volatile int top;          // next task to steal
+  volatile int bottom;       // next free slot, only moved by the owner
+  struct task deque[DEQUESIZE];
+  uint seed;                 // for picking victims
+  thread_t tid;
+};
+
+struct {
+  struct worker worker[MAXWORKER];
+  int nworker;
+  thread_mutex_t injectlock;
+  struct task inject[INJECTSIZE];
+  int injecthead, injectn;
+  volatile int ninject;      // injectn, read without the lock
+  volatile int parkseq;      // futex word of the parked workers
+  volatile int nparked;
+  volatile int stop;
+} pool;
+
+// Push t on the bottom of w's deque. Only the owner of w pushes.
+// Return -1 if the deque is full.
+static int
+push(struct worker *w, struct task *t)
+{
+  int b = w->bottom;
+
+  if(b - w->top >= DEQUESIZE)
+    return -1;
+  w->deque[b & (DEQUESIZE - 1)] = *t;
+  asm volatile("" : : : "memory");  // the task is stored before it is published
+  w->bottom = b + 1;
+  return 0;
+}
+
+// Pop the bottom task of w's deque into t. Only the owner of w pops.
+// Return -1 if the deque is empty.
+static int
+pop(struct worker *w, struct task *t)
+{
+  int b, top;
+
+  b = w->bottom - 1;
+  w->bottom = b;
+  mfence();                  // thieves see the new bottom before we read top
+  top = w->top;
+  if(top > b){
+    w->bottom = top;
+    return -1;
+  }
+  *t = w->deque[b & (DEQUESIZE - 1)];
+  if(top == b){
+    // last task, race the thieves for it
+    if(cmpxchg(&w->top, top, top + 1) != top){
+      w->bottom = top + 1;
+      return -1;
+    }
+    w->bottom = top + 1;
+  }
+  return 0;
+}
+
+// Steal the top task of w's deque into t.
+// Return -1 if it is empty or another thief got there first.
+static int
+steal(struct worker *w, struct task *t)
+{
+  int top, b;
+
+  top = w->top;
+  asm volatile("" : : : "memory");
+  b = w->bottom;
+  if(top >= b)
+    return -1;
+  *t = w->deque[top & (DEQUESIZE - 1)];
+  if(cmpxchg(&w->top, top, top + 1) != top)
+    return -1;
+  return 0;
+}
+
+// Wake up a parked worker, if any, for a task just pushed.
+static void
+notify(void)
+{
+  mfence();                  // the push is visible before nparked is read
+  if(pool.nparked > 0){
+    fetchadd(&pool.parkseq, 1);
+    futex((int*)&pool.parkseq, FUTEX_WAKE, 1, 0);
+  }
+}
+
+static int
+takeinject(struct task *t)
+{
+  int ok = -1;
+
+  if(pool.ninject == 0)
+    return -1;
+  thread_mutex_lock(&pool.injectlock);
+  if(pool.injectn > 0){
+    *t = pool.inject[pool.injecthead];
+    pool.injecthead = (pool.injecthead + 1) % INJECTSIZE;
+    pool.ninject = --pool.injectn;
+    ok = 0;
+  }
+  thread_mutex_unlock(&pool.injectlock);
+  return ok;
+}
+
+static void
+finish(struct uthreadgroup *g)
+{
+  if(fetchadd(&g->pending, -1) == 1)
+    futex((int*)&g->pending, FUTEX_WAKE, 1, 0);
+}
+
+// Run t on worker w, leaving halves of its range for others to steal.
+static void
+run(struct worker *w, struct task *t)
+{
+  struct task half;
+  int mid;
+
+  while(t->hi - t->lo > t->grain){
+    mid = t->lo + (t->hi - t->lo) / 2;
+    half = *t;
+    half.lo = mid;
+    fetchadd(&t->group->pending, 1);
+    if(push(w, &half) < 0){
+      // deque full, keep the whole range
+      fetchadd(&t->group->pending, -1);
+      break;
+    }
+    notify();
+    t->hi = mid;
+  }
+  t->fn(t->arg, t->lo, t->hi);
+  finish(t->group);
+}
+
+// Find a task for w: its own deque first, then the inject queue,
+// then the deques of the other workers from a random one on.
+static int
+findtask(struct worker *w, struct task *t)
+{
+  int i, v;
+
+  if(pop(w, t) == 0 || takeinject(t) == 0)
+    return 0;
+  w->seed = w->seed * 1103515245 + 12345;
+  v = (w->seed >> 16) % pool.nworker;
+  for(i = 0; i < pool.nworker; i++, v = (v + 1) % pool.nworker)
+    if(&pool.worker[v] != w && steal(&pool.worker[v], t) == 0)
+      return 0;
+  return -1;
+}
+
+static void*
+workermain(void *arg)
+{
+  struct worker *w = arg;
+  struct task t;
+  int spin, seq;
+
+  while(!pool.stop){
+    for(spin = 0; spin < NSPIN; spin++){
+      if(findtask(w, &t) == 0){
+        run(w, &t);
+        spin = -1;
+      }
+      if(pool.stop)
+        break;
+    }
+    // park; a push after parkseq is read changes it and fails the wait
+    seq = pool.parkseq;
+    fetchadd(&pool.nparked, 1);
+    if(findtask(w, &t) == 0){
+      fetchadd(&pool.nparked, -1);
+      run(w, &t);
+      continue;
+    }
+    if(!pool.stop)
+      futex((int*)&pool.parkseq, FUTEX_WAIT, seq, 0);
+    fetchadd(&pool.nparked, -1);
+  }
+  thread_exit(0);
+  return 0;
+}
+
+// Start nworker workers, one per cpu if nworker is 0.
+// Return 0 on success, -1 on failure.
+int
+uthreadpool_init(int nworker)
+{
+  int i;
+
+  if(nworker <= 0)
+    nworker = getncpu();
+  if(nworker > MAXWORKER)
+    nworker = MAXWORKER;
+  memset(&pool, 0, sizeof(pool));
+  thread_mutex_init(&pool.injectlock);
+  pool.nworker = nworker;
+  for(i = 0; i < nworker; i++){
+    pool.worker[i].seed = i + 1;
+    if(thread_create2(&pool.worker[i].tid, workermain, &pool.worker[i], WORKERSTACK) != 0){
+      pool.nworker = i;
+      uthreadpool_exit();
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Stop and join the workers. Submitted tasks must have finished.
+void
+uthreadpool_exit(void)
+{
+  void *retval;
+  int i;
+
+  pool.stop = 1;
+  fetchadd(&pool.parkseq, 1);
+  futex((int*)&pool.parkseq, FUTEX_WAKE, MAXWORKER, 0);
+  for(i = 0; i < pool.nworker; i++)
+    thread_join(pool.worker[i].tid, &retval);
+  pool.nworker = 0;
+}
+
+// Queue fn on the range [lo, hi) as a task of g. Called from outside
+// the pool; waits while the inject queue is full.
+void
+uthreadpool_submit(struct uthreadgroup *g, uthreadfn fn, void *arg, int lo, int hi, int grain)
+{
+  struct task t;
+
+  t.fn = fn;
+  t.arg = arg;
+  t.lo = lo;
+  t.hi = hi;
+  t.grain = grain > 0 ? grain : 1;
+  t.group = g;
+  fetchadd(&g->pending, 1);
+
+  thread_mutex_lock(&pool.injectlock);
+  while(pool.injectn == INJECTSIZE){
+    thread_mutex_unlock(&pool.injectlock);
+    sleep(0);
+    thread_mutex_lock(&pool.injectlock);
+  }
+  pool.inject[(pool.injecthead + pool.injectn) % INJECTSIZE] = t;
+  pool.ninject = ++pool.injectn;
+  thread_mutex_unlock(&pool.injectlock);
+  notify();
+}
+
+// Wait until all the tasks of g have finished.
+void
+uthreadpool_wait(struct uthreadgroup *g)
+{
+  int n;
+
+  while((n = g->pending) != 0)
+    futex((int*)&g->pending, FUTEX_WAIT, n, 0);
+}
+
+// Run body(arg, lo', hi') over [lo, hi) in pieces of at most grain.
+void
+uthreadpool_for(int lo, int hi, int grain, uthreadfn body, void *arg)
+{
+  struct uthreadgroup g;
+
+  g.pending = 0;
+  uthreadpool_submit(&g, body, arg, lo, hi, grain);
+  uthreadpool_wait(&g);
+}
+
+struct reduce {
+  int (*body)(void*, int, int);
+  void *arg;
+  volatile int sum;
+};
+
+static void
+reduceleaf(void *arg, int lo, int hi)
+{
+  struct reduce *r = arg;
+
+  fetchadd(&r->sum, r->body(r->arg, lo, hi));
+}
+
+// Sum of body(arg, lo', hi') over pieces of [lo, hi) of at most grain.
+int
+uthreadpool_reduce(int lo, int hi, int grain, int (*body)(void*, int, int), void *arg)
+{
+  struct reduce r;
+
+  r.body = body;
+  r.arg = arg;
+  r.sum = 0;
+  uthreadpool_for(lo, hi, grain, reduceleaf, &r);
+  return r.sum;
+}
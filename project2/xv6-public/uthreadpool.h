@@ -0,0 +1,21 @@
+// Thread pool of one worker LWP per cpu with work-stealing deques.
+// Include after user.h.
+
+#define MAXWORKER 8          // NCPU
+
+// A task runs fn(arg, lo, hi) on a range. Ranges wider than grain are
+// split in halves, one of which is left for other workers to steal.
+typedef void (*uthreadfn)(void *arg, int lo, int hi);
+
+// Tasks submitted together, see uthreadpool_wait.
+struct uthreadgroup {
+  volatile int pending;      // tasks not finished yet
+};
+
+// uthreadpool.c
+int uthreadpool_init(int nworker);
+void uthreadpool_exit(void);
+void uthreadpool_submit(struct uthreadgroup*, uthreadfn, void *arg, int lo, int hi, int grain);
+void uthreadpool_wait(struct uthreadgroup*);
+void uthreadpool_for(int lo, int hi, int grain, uthreadfn, void *arg);
+int uthreadpool_reduce(int lo, int hi, int grain, int (*body)(void*, int, int), void *arg);
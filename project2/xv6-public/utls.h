@@ -0,0 +1,38 @@
+// t9: thread-local storage of threads created with thread_create3.
+// %gs of such a thread selects its TLS block. The first word of the
+// block holds the block's own address, the tlssize bytes asked for
+// follow it and start out zeroed. Threads created without a TLS block
+// have a null %gs, and using these accessors there faults.
+
+#define TLS_DATA 4  // offset of the user bytes in the block
+
+// Flat address of the user bytes of the calling thread's block, to
+// reach a struct kept in TLS through an ordinary pointer.
+static inline void*
+tls_data(void)
+{
+  char *self;
+
+  asm volatile("movl %%gs:0, %0" : "=r" (self));
+  return self + TLS_DATA;
+}
+
+// Word at byte off of the user bytes, loaded straight through %gs.
+static inline uint
+tls_get(uint off)
+{
+  uint v;
+
+  asm volatile("movl %%gs:4(%1), %0" : "=r" (v) : "r" (off) : "memory");
+  return v;
+}
+
+static inline void
+tls_set(uint off, uint v)
+{
+  asm volatile("movl %0, %%gs:4(%1)" : : "r" (v), "r" (off) : "memory");
+}
+
+// The thread-local variable of the given type at byte off of the
+// user bytes, like __thread: TLS_VAR(struct cache, 0)->nfree++.
+#define TLS_VAR(type, off) ((type*)((char*)tls_data() + (off)))
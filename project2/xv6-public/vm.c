@@ -26,6 +26,7 @@ seginit(void)
   c->gdt[SEG_KDATA] = SEG(STA_W, 0, 0xffffffff, 0);
   c->gdt[SEG_UCODE] = SEG(STA_X|STA_R, 0, 0xffffffff, DPL_USER);
   c->gdt[SEG_UDATA] = SEG(STA_W, 0, 0xffffffff, DPL_USER);
+  c->gdt[SEG_UTLS] = SEG16(STA_W, 0, 0, DPL_USER);
   lgdt(c->gdt, sizeof(c->gdt));
 }
 
@@ -160,7 +161,7 @@ switchuvm(struct proc *p)
     panic("switchuvm: no process");
   if(p->kstack == 0)
     panic("switchuvm: no kstack");
-  if(p->pgdir == 0)
+  if(p->share->pgdir == 0)
     panic("switchuvm: no pgdir");
 
   pushcli();
@@ -173,7 +174,11 @@ switchuvm(struct proc *p)
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
   ltr(SEG_TSS << 3);
-  lcr3(V2P(p->pgdir));  // switch to process's address space
+  // t9: %gs of the thread is reloaded from here on the way back to user space.
+  // A thread without TLS gets an empty segment, which is still present so that
+  // a user %gs pointing at it never faults in trapret.
+  mycpu()->gdt[SEG_UTLS] = SEG16(STA_W, p->tlsbase, p->tlssize ? p->tlssize - 1 : 0, DPL_USER);
+  lcr3(V2P(p->share->pgdir));  // switch to process's address space
   popcli();
 }
 
@@ -310,33 +315,47 @@ clearpteu(pde_t *pgdir, char *uva)
   *pte &= ~PTE_U;
 }
 
+// Copy the user page at va of pgdir into page table d.
+static int
+copypage(pde_t *pgdir, pde_t *d, uint va)
+{
+  pte_t *pte;
+  uint pa, flags;
+  char *mem;
+
+  if((pte = walkpgdir(pgdir, (void *) va, 0)) == 0)
+    panic("copyuvm: pte should exist");
+  if(!(*pte & PTE_P))
+    panic("copyuvm: page not present");
+  pa = PTE_ADDR(*pte);
+  flags = PTE_FLAGS(*pte);
+  if((mem = kalloc()) == 0)
+    return -1;
+  memmove(mem, (char*)P2V(pa), PGSIZE);
+  if(mappages(d, (void*)va, PGSIZE, V2P(mem), flags) < 0) {
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
 // Given a parent process's page table, create a copy
-// of it for a child.
+// of it for a child: [0, sz) and the thread stacks in
+// [stackbase, USTACKTOP).
 pde_t*
-copyuvm(pde_t *pgdir, uint sz)
+copyuvm(pde_t *pgdir, uint sz, uint stackbase)
 {
   pde_t *d;
-  pte_t *pte;
-  uint pa, i, flags;
-  char *mem;
+  uint i;
 
   if((d = setupkvm()) == 0)
     return 0;
-  for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
-    pa = PTE_ADDR(*pte);
-    flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
+  for(i = 0; i < sz; i += PGSIZE)
+    if(copypage(pgdir, d, i) < 0)
       goto bad;
-    memmove(mem, (char*)P2V(pa), PGSIZE);
-    if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0) {
-      kfree(mem);
+  for(i = stackbase; i < USTACKTOP; i += PGSIZE)
+    if(copypage(pgdir, d, i) < 0)
       goto bad;
-    }
-  }
   return d;
 
 bad:
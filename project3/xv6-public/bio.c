@@ -5,6 +5,13 @@
 // in memory reduces the number of disk reads and also provides
 // a synchronization point for disk blocks used by multiple processes.
 //
+// The buffers are allocated at boot from free physical memory, one
+// BCACHEFRAC-th of it, and looked up through a hash table keyed by
+// (dev, blockno). The hash table is split into NBUCKET buckets, each
+// with its own lock and LRU list of the buffers whose blocks hash
+// into it, so processes working on different blocks rarely contend.
+// A bucket with no buffer to recycle steals one from another bucket.
+//
 // Interface:
 // * To get a buffer for a particular disk block, call bread.
 // * After changing buffer data, call bwrite to write it to disk.
@@ -13,83 +20,273 @@
 // * Only one process at a time can use a buffer,
 //     so do not keep them longer than necessary.
 //
-// The implementation uses two state flags internally:
+// * To start reading a block that will be needed soon without
+//     waiting for it, call breada.
+//
+// The implementation uses these state flags internally:
 // * B_VALID: the buffer data has been read from the disk.
 // * B_DIRTY: the buffer data has been modified
 //     and needs to be written to disk.
+// * B_AHEAD: the buffer is being read ahead; the disk interrupt
+//     releases it when the read is done.
 
 #include "types.h"
 #include "defs.h"
 #include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "fs.h"
 #include "buf.h"
 
-struct {
+#define BUFPERPAGE (PGSIZE / sizeof(struct buf))
+#define BHASHBITS  14
+#define NBHASH     (1 << BHASHBITS)  // about two buffers per chain at most
+#define BUCKETBITS 6
+#define NBUCKET    (1 << BUCKETBITS) // locked shards of the hash table
+
+struct bucket {
   struct spinlock lock;
-  struct buf buf[NBUF];
 
-  // Linked list of all buffers, through prev/next.
+  // Linked list of the buffers of the bucket, through prev/next.
   // head.next is most recently used.
   struct buf head;
+};
+
+struct {
+  int nbuf;
+  struct bucket bucket[NBUCKET];
+
+  // Hash chains of the buffers holding a block, through hnext.
+  // A chain is guarded by the lock of the bucket it falls in.
+  struct buf *hash[NBHASH];
 } bcache;
 
+static uint
+bhash(uint dev, uint blockno)
+{
+  return ((blockno ^ (dev << 24)) * 2654435761U) >> (32 - BHASHBITS);
+}
+
+// Bucket of hash chain h.
+static struct bucket*
+bbucket(uint h)
+{
+  return &bcache.bucket[h >> (BHASHBITS - BUCKETBITS)];
+}
+
+// Link b at the most recently used end of the LRU list of bk.
+static void
+blruadd(struct bucket *bk, struct buf *b)
+{
+  b->next = bk->head.next;
+  b->prev = &bk->head;
+  bk->head.next->prev = b;
+  bk->head.next = b;
+}
+
+static void
+blruremove(struct buf *b)
+{
+  b->next->prev = b->prev;
+  b->prev->next = b->next;
+}
+
+// Cached buffer of block blockno on device dev, on hash chain h.
+// The lock of the bucket of h must be held.
+static struct buf*
+blookup(uint h, uint dev, uint blockno)
+{
+  struct buf *b;
+
+  for(b = bcache.hash[h]; b != 0; b = b->hnext)
+    if(b->dev == dev && b->blockno == blockno)
+      return b;
+  return 0;
+}
+
+// Remove b from its hash chain, if it is on one.
+// Buffers never used yet are on none.
+// The lock of the bucket of b must be held.
+static void
+bunhash(struct buf *b)
+{
+  struct buf **pp;
+
+  for(pp = &bcache.hash[bhash(b->dev, b->blockno)]; *pp != 0; pp = &(*pp)->hnext){
+    if(*pp == b){
+      *pp = b->hnext;
+      break;
+    }
+  }
+  b->hnext = 0;
+}
+
+// Least recently used buffer of bk that can be recycled, or 0.
+// Even if refcnt==0, B_DIRTY indicates a buffer is in use
+// because log.c has modified it but not yet committed it.
+// The lock of bk must be held.
+static struct buf*
+bvictim(struct bucket *bk)
+{
+  struct buf *b;
+
+  for(b = bk->head.prev; b != &bk->head; b = b->prev)
+    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0)
+      return b;
+  return 0;
+}
+
+// Give the unused buffer b, taken off its old hash chain and LRU list,
+// to block blockno on device dev, on hash chain h of bucket bk.
+// The lock of bk must be held.
+static void
+bassign(struct bucket *bk, struct buf *b, uint h, uint dev, uint blockno)
+{
+  b->dev = dev;
+  b->blockno = blockno;
+  b->flags = 0;
+  b->refcnt = 1;
+  b->hnext = bcache.hash[h];
+  bcache.hash[h] = b;
+  blruadd(bk, b);
+}
+
+// Take the locks of two buckets, always in the same order.
+static void
+block2(struct bucket *a, struct bucket *b)
+{
+  if(a > b){
+    acquire(&b->lock);
+    acquire(&a->lock);
+  } else {
+    acquire(&a->lock);
+    acquire(&b->lock);
+  }
+}
+
+// Allocate the buffers from free physical memory: one BCACHEFRAC-th
+// of it, at least NBUF and at most a buffer per file system block.
+// Must be called after kinit2.
 void
 binit(void)
 {
+  struct bucket *bk;
   struct buf *b;
+  char *page;
+  int n;
+
+  for(bk = bcache.bucket; bk < bcache.bucket+NBUCKET; bk++){
+    initlock(&bk->lock, "bcache.bucket");
+    bk->head.prev = &bk->head;
+    bk->head.next = &bk->head;
+  }
 
-  initlock(&bcache.lock, "bcache");
+  n = kfreepages() / BCACHEFRAC * BUFPERPAGE;
+  if(n < NBUF)
+    n = NBUF;
+  if(n > FSSIZE)
+    n = FSSIZE;
 
 //PAGEBREAK!
-  // Create linked list of buffers
-  bcache.head.prev = &bcache.head;
-  bcache.head.next = &bcache.head;
-  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    initsleeplock(&b->lock, "buffer");
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
+  // Create linked lists of buffers. An unused buffer is named
+  // (0, its number) without being hashed, so the buffers spread over
+  // the buckets and each lives in the bucket its name falls in.
+  for(bcache.nbuf = 0; bcache.nbuf < n; ){
+    if((page = kalloc()) == 0)
+      break;
+    memset(page, 0, PGSIZE);
+    for(b = (struct buf*)page; b < (struct buf*)page + BUFPERPAGE && bcache.nbuf < n; b++){
+      b->blockno = bcache.nbuf++;
+      initsleeplock(&b->lock, "buffer");
+      blruadd(bbucket(bhash(b->dev, b->blockno)), b);
+    }
+  }
+  if(bcache.nbuf < NBUF)
+    panic("binit: no memory");
+}
+
+// Recycle a buffer of another bucket for block blockno on device
+// dev, on hash chain h of bucket bk. Called without locks; the block
+// may have been cached in the meantime, then that buffer is returned,
+// or 0 for a read-ahead, which must not wait for the buffer.
+// Return 0 if no buffer can be recycled.
+static struct buf*
+bsteal(struct bucket *bk, uint h, uint dev, uint blockno, int ahead)
+{
+  struct bucket *from;
+  struct buf *b;
+  int i;
+
+  for(i = 1; i < NBUCKET; i++){
+    from = &bcache.bucket[(bk - bcache.bucket + i) % NBUCKET];
+    block2(bk, from);
+    if((b = blookup(h, dev, blockno)) != 0){
+      if(ahead){
+        release(&from->lock);
+        release(&bk->lock);
+        return 0;
+      }
+      b->refcnt++;
+    } else if((b = bvictim(bk)) != 0 || (b = bvictim(from)) != 0){
+      bunhash(b);
+      blruremove(b);
+      bassign(bk, b, h, dev, blockno);
+    }
+    release(&from->lock);
+    release(&bk->lock);
+    if(b != 0)
+      return b;
   }
+  return 0;
 }
 
 // Look through buffer cache for block on device dev.
 // If not found, allocate a buffer.
 // In either case, return locked buffer.
+// For a read-ahead, return 0 instead if the block is cached already
+// or no buffer is free.
 static struct buf*
-bget(uint dev, uint blockno)
+bget(uint dev, uint blockno, int ahead)
 {
+  struct bucket *bk;
   struct buf *b;
+  uint h;
 
-  acquire(&bcache.lock);
+  h = bhash(dev, blockno);
+  bk = bbucket(h);
+  acquire(&bk->lock);
 
   // Is the block already cached?
-  for(b = bcache.head.next; b != &bcache.head; b = b->next){
-    if(b->dev == dev && b->blockno == blockno){
-      b->refcnt++;
-      release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+  if((b = blookup(h, dev, blockno)) != 0){
+    if(ahead){
+      release(&bk->lock);
+      return 0;
     }
+    b->refcnt++;
+    release(&bk->lock);
+    acquiresleep(&b->lock);
+    return b;
   }
 
-  // Not cached; recycle an unused buffer.
-  // Even if refcnt==0, B_DIRTY indicates a buffer is in use
-  // because log.c has modified it but not yet committed it.
-  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
-    if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0) {
-      b->dev = dev;
-      b->blockno = blockno;
-      b->flags = 0;
-      b->refcnt = 1;
-      release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+  // Not cached; recycle an unused buffer of the bucket,
+  // or of another bucket if it has none.
+  if((b = bvictim(bk)) != 0){
+    bunhash(b);
+    blruremove(b);
+    bassign(bk, b, h, dev, blockno);
+    release(&bk->lock);
+  } else {
+    release(&bk->lock);
+    if((b = bsteal(bk, h, dev, blockno, ahead)) == 0){
+      if(ahead)
+        return 0;
+      panic("bget: no buffers");
     }
   }
-  panic("bget: no buffers");
+  acquiresleep(&b->lock);
+  return b;
 }
 
 // Return a locked buf with the contents of the indicated block.
@@ -98,13 +295,56 @@ bread(uint dev, uint blockno)
 {
   struct buf *b;
 
-  b = bget(dev, blockno);
+  b = bget(dev, blockno, 0);
   if((b->flags & B_VALID) == 0) {
     iderw(b);
   }
   return b;
 }
 
+// Start reading block blockno into the cache, unless it is cached
+// already, and return without waiting for the disk.
+void
+breada(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  // a buffer from bget here is a fresh one, so it has no valid data
+  if((b = bget(dev, blockno, 1)) == 0)
+    return;
+  idereadahead(b);
+}
+
+// Locked buf of block blockno if it is cached, valid and not
+// locked by someone else, without waiting for the disk or the
+// holder. Otherwise start reading it if it is not cached and
+// return 0.
+struct buf*
+bpeek(uint dev, uint blockno)
+{
+  struct bucket *bk;
+  struct buf *b;
+  uint h;
+
+  h = bhash(dev, blockno);
+  bk = bbucket(h);
+  acquire(&bk->lock);
+  if((b = blookup(h, dev, blockno)) != 0){
+    // still being read, or held, e.g. by install_trans across a
+    // whole disk write
+    if((b->flags & B_VALID) == 0 || !tryacquiresleep(&b->lock)){
+      release(&bk->lock);
+      return 0;
+    }
+    b->refcnt++;
+    release(&bk->lock);
+    return b;
+  }
+  release(&bk->lock);
+  breada(dev, blockno);
+  return 0;
+}
+
 // Write b's contents to disk.  Must be locked.
 void
 bwrite(struct buf *b)
@@ -115,45 +355,77 @@ bwrite(struct buf *b)
   iderw(b);
 }
 
-// Release a locked buffer.
-// Move to the head of the MRU list.
+// Write the contents of n locked bufs to disk at once,
+// letting the disk driver sort and merge the writes.
 void
-brelse(struct buf *b)
+bwritev(struct buf **bufs, int n)
 {
-  if(!holdingsleep(&b->lock))
-    panic("brelse");
+  int i;
+
+  for(i = 0; i < n; i++){
+    if(!holdingsleep(&bufs[i]->lock))
+      panic("bwritev");
+    bufs[i]->flags |= B_DIRTY;
+  }
+  iderwv(bufs, n);
+}
+
+// Unlock b and drop a reference to it.
+static void
+bput(struct buf *b)
+{
+  struct bucket *bk;
 
   releasesleep(&b->lock);
 
-  acquire(&bcache.lock);
+  // b keeps its block while referenced, so it stays in this bucket
+  bk = bbucket(bhash(b->dev, b->blockno));
+  acquire(&bk->lock);
   b->refcnt--;
   if (b->refcnt == 0) {
     // no one is waiting for it.
-    b->next->prev = b->prev;
-    b->prev->next = b->next;
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
+    blruremove(b);
+    blruadd(bk, b);
   }
   
-  release(&bcache.lock);
+  release(&bk->lock);
+}
+
+// Release a locked buffer.
+// Move to the head of the MRU list of its bucket.
+void
+brelse(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("brelse");
+  bput(b);
+}
+
+// Release the buffer of a finished read-ahead, from the disk
+// interrupt. b is locked on behalf of the process that started
+// the read, so it is not checked against the current process.
+void
+breadadone(struct buf *b)
+{
+  bput(b);
 }
 
 int
 bfull(void) {
+  struct bucket *bk;
   struct buf *b;
 
-  acquire(&bcache.lock);
-
-  for(b = bcache.head.next; b != &bcache.head; b = b->next){
-    if((b->flags & B_DIRTY) == 0){
-      release(&bcache.lock);
-      return 0;
+  for(bk = bcache.bucket; bk < bcache.bucket+NBUCKET; bk++){
+    acquire(&bk->lock);
+    for(b = bk->head.next; b != &bk->head; b = b->next){
+      if((b->flags & B_DIRTY) == 0){
+        release(&bk->lock);
+        return 0;
+      }
     }
+    release(&bk->lock);
   }
 
-  release(&bcache.lock);
   return 1;
 }
 
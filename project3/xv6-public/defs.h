@@ -15,6 +15,10 @@ void            binit(void);
 struct buf*     bread(uint, uint);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
+void            bwritev(struct buf**, int);
+void            breada(uint, uint);
+struct buf*     bpeek(uint, uint);
+void            breadadone(struct buf*);
 int				bfull(void);
 
 // console.c
@@ -51,6 +55,7 @@ int             namecmp(const char*, const char*);
 struct inode*   namei(char*);
 struct inode*   nameiparent(char*, char*);
 int             readi(struct inode*, char*, uint, uint);
+int             ireadahead(struct inode*, uint, uint);
 void            stati(struct inode*, struct stat*);
 int             writei(struct inode*, char*, uint, uint);
 
@@ -58,6 +63,8 @@ int             writei(struct inode*, char*, uint, uint);
 void            ideinit(void);
 void            ideintr(void);
 void            iderw(struct buf*);
+void            iderwv(struct buf**, int);
+void            idereadahead(struct buf*);
 
 // ioapic.c
 void            ioapicenable(int irq, int cpu);
@@ -66,6 +73,7 @@ void            ioapicinit(void);
 
 // kalloc.c
 char*           kalloc(void);
+int             kfreepages(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
@@ -93,6 +101,11 @@ int             sync(void);
 extern int      ismp;
 void            mpinit(void);
 
+// pci.c
+uint            pciconfread(int, int, int);
+void            pciconfwrite(int, int, int, uint);
+int             pcifind(int, int, int*, int*);
+
 // picirq.c
 void            picenable(int);
 void            picinit(void);
@@ -137,6 +150,7 @@ void            popcli(void);
 
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
+int             tryacquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
 int             holdingsleep(struct sleeplock*);
 void            initsleeplock(struct sleeplock*, char*);
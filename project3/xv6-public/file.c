@@ -95,11 +95,44 @@ filestat(struct file *f, struct stat *st)
   return -1;
 }
 
+// Read ahead of a read of f that started in block first and has
+// moved f->off past it. While reads stay sequential the window
+// doubles up to RAMAX blocks, and it is refilled once half of it has
+// been read. A read elsewhere closes the window.
+// Caller must hold f->ip->lock.
+static void
+fileahead(struct file *f, uint first)
+{
+  uint next, start, end;
+
+  if(first == f->ranext){
+    if(f->rawin == 0)
+      f->rawin = RAMIN;
+    else if(f->rawin < RAMAX)
+      f->rawin *= 2;
+  } else {
+    f->rawin = 0;
+    f->raend = 0;
+  }
+  // the block of f->off may only be partly read
+  next = (f->off + BSIZE - 1) / BSIZE;
+  f->ranext = f->off / BSIZE;
+  if(f->rawin == 0)
+    return;
+
+  start = f->raend > next ? f->raend : next;
+  end = next + f->rawin;
+  if(start >= next + f->rawin / 2)
+    return;
+  f->raend = start + ireadahead(f->ip, start, end - start);
+}
+
 // Read from file f.
 int
 fileread(struct file *f, char *addr, int n)
 {
   int r;
+  uint first;
 
   if(f->readable == 0)
     return -1;
@@ -107,8 +140,11 @@ fileread(struct file *f, char *addr, int n)
     return piperead(f->pipe, addr, n);
   if(f->type == FD_INODE){
     ilock(f->ip);
-    if((r = readi(f->ip, addr, f->off, n)) > 0)
+    first = f->off / BSIZE;
+    if((r = readi(f->ip, addr, f->off, n)) > 0){
       f->off += r;
+      fileahead(f, first);
+    }
     iunlock(f->ip);
     return r;
   }
@@ -6,6 +6,9 @@ struct file {
   struct pipe *pipe;
   struct inode *ip;
   uint off;
+  uint ranext; // block the next read starts in if reading sequentially
+  uint rawin;  // read-ahead window in blocks, 0 if not sequential
+  uint raend;  // read-ahead started up to this block
 };
 
 
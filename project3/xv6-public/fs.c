@@ -481,6 +481,66 @@ bmap(struct inode *ip, uint bn)
   panic("bmap: out of range");
 }
 
+// Disk block address of the nth block in inode ip for a read-ahead:
+// like bmap, but never allocates and never waits for the disk.
+// Return 0 if the block is a hole or an indirect block on the way to
+// it is not cached yet; the read of that indirect block is started.
+static uint
+bmapahead(struct inode *ip, uint bn)
+{
+  uint addr, span;
+  int level;
+  struct buf *bp;
+
+  if (bn < NDIRECT)
+    return ip->addrs[bn];
+  bn -= NDIRECT;
+
+  // 몇 단계의 indirect block을 거쳐야 하는지 구한다
+  span = 1;
+  for (level = 1; level <= 3; level++)
+  {
+    span *= NINDIRECT;
+    if (bn < span)
+      break;
+    bn -= span;
+  }
+  if (level > 3)
+    return 0;
+  addr = ip->addrs[NDIRECT + level - 1];
+
+  // 위 단계의 indirect block부터 cache에 있는 것만 따라 내려간다
+  for (; level > 0 && addr != 0; level--)
+  {
+    span /= NINDIRECT;
+    if ((bp = bpeek(ip->dev, addr)) == 0)
+      return 0;
+    addr = ((uint *)bp->data)[(bn / span) % NINDIRECT];
+    brelse(bp);
+  }
+  return addr;
+}
+
+// Start reading blocks bn..bn+n-1 of inode ip into the buffer cache
+// without waiting for them, stopping at the end of the file or at the
+// first block whose address is not known yet (see bmapahead).
+// Return the number of blocks started or found cached.
+// Caller must hold ip->lock.
+int ireadahead(struct inode *ip, uint bn, uint n)
+{
+  uint i, addr;
+
+  if (ip->type != T_FILE)
+    return 0;
+  for (i = 0; i < n && (bn + i) * BSIZE < ip->size; i++)
+  {
+    if ((addr = bmapahead(ip, bn + i)) == 0)
+      break;
+    breada(ip->dev, addr);
+  }
+  return i;
+}
+
 // Truncate inode (discard contents).
 // Only called when the inode has no links
 // to it (no directory entries referring to it)
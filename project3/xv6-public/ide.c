@@ -1,4 +1,7 @@
-// Simple PIO-based (non-DMA) IDE driver code.
+// Simple IDE driver code.
+// Requests are served in elevator order, consecutive blocks
+// merged into multi-sector commands. Blocks move by bus-master
+// DMA if the PCI IDE controller can, else by PIO.
 
 #include "types.h"
 #include "defs.h"
@@ -12,6 +15,7 @@
 #include "sleeplock.h"
 #include "fs.h"
 #include "buf.h"
+#include "pci.h"
 
 #define SECTOR_SIZE   512
 #define IDE_BSY       0x80
@@ -23,16 +27,48 @@
 #define IDE_CMD_WRITE 0x30
 #define IDE_CMD_RDMUL 0xc4
 #define IDE_CMD_WRMUL 0xc5
+#define IDE_CMD_SETMUL 0xc6
+#define IDE_CMD_RDDMA 0xc8
+#define IDE_CMD_WRDMA 0xca
 
-// idequeue points to the buf now being read/written to the disk.
-// idequeue->qnext points to the next buf to be processed.
+#define IDE_MULT      16    // max sectors per READ/WRITE MULTIPLE command
+#define IDE_NPRD      64    // max bufs per DMA command
+#define IDE_NIEN      0x02  // device control: interrupts off
+
+// Bus-master registers of the primary channel, at idebm
+#define BM_CMD        0
+#define BM_STATUS     2
+#define BM_PRDT       4
+#define BM_START      0x01  // BM_CMD: start transfer
+#define BM_TOMEM      0x08  // BM_CMD: transfer from disk to memory
+#define BM_ERR        0x02  // BM_STATUS: error, write 1 to clear
+#define BM_IRQ        0x04  // BM_STATUS: interrupt, write 1 to clear
+
+// Physical region descriptor: one buf of a DMA transfer.
+struct prd {
+  uint addr;
+  ushort count;
+  ushort flags;
+};
+#define PRD_EOT       0x8000  // last descriptor of the table
+
+// idequeue points to the bufs now being read/written to the disk,
+// the first idenactive of the queue, which are consecutive blocks
+// handled by one command. The rest of the queue waits in C-LOOK
+// elevator order: up from the blocks in progress, then from the
+// lowest block up again. Runs of consecutive blocks in the queue
+// are merged into one READ/WRITE MULTIPLE command.
 // You must hold idelock while manipulating queue.
 
 static struct spinlock idelock;
 static struct buf *idequeue;
+static int idenactive;
 
 static int havedisk1;
-static void idestart(struct buf*);
+static int idemult[2];  // sectors per MULTIPLE block of each disk, 0 if none
+static ushort idebm;    // bus-master I/O base, 0 if no DMA
+static struct prd *ideprdt;
+static void idestart(void);
 
 // Wait for IDE disk to become ready.
 static int
@@ -47,6 +83,46 @@ idewait(int checkerr)
   return 0;
 }
 
+// Let disk transfer up to IDE_MULT sectors per interrupt with
+// READ/WRITE MULTIPLE. Return the sectors per interrupt, 0 if
+// the disk cannot.
+static int
+idesetmult(int disk)
+{
+  idewait(0);
+  outb(0x3f6, IDE_NIEN);  // the command would interrupt with no request queued
+  outb(0x1f6, 0xe0 | (disk<<4));
+  outb(0x1f2, IDE_MULT);
+  outb(0x1f7, IDE_CMD_SETMUL);
+  if(idewait(1) < 0)
+    return 0;
+  return IDE_MULT;
+}
+
+// Find the PCI IDE controller and set up bus-master DMA if it
+// can do it. The disks stay on the legacy ports either way.
+static void
+idedmainit(void)
+{
+  int dev, func;
+  uint cls, bar;
+
+  if(pcifind(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, &dev, &func) < 0)
+    return;
+  cls = pciconfread(dev, func, PCI_CLASS);
+  bar = pciconfread(dev, func, PCI_BAR4);
+  // prog if bit 7: bus master; BAR4 must be an assigned I/O range
+  if((cls & 0x8000) == 0 || (bar & 1) == 0 || (bar & ~3) == 0)
+    return;
+  if((ideprdt = (struct prd*)kalloc()) == 0)
+    return;
+  pciconfwrite(dev, func, PCI_COMMAND,
+               pciconfread(dev, func, PCI_COMMAND) | PCI_CMD_IO | PCI_CMD_MASTER);
+  idebm = bar & 0xfffc;
+  outb(idebm + BM_CMD, 0);
+  outb(idebm + BM_STATUS, BM_ERR | BM_IRQ);
+}
+
 void
 ideinit(void)
 {
@@ -64,70 +140,188 @@ ideinit(void)
       break;
     }
   }
+  if(havedisk1)
+    idemult[1] = idesetmult(1);
+  idemult[0] = idesetmult(0);
+  idedmainit();
 
   // Switch back to disk 0.
   outb(0x1f6, 0xe0 | (0<<4));
 }
 
-// Start the request for b.  Caller must hold idelock.
+// Start the request for the bufs at the head of idequeue: the first
+// one and the bufs right after it in the queue that continue it on
+// the disk in the same direction.  Caller must hold idelock.
 static void
-idestart(struct buf *b)
+idestart(void)
 {
-  if(b == 0)
+  struct buf *b, *last;
+  struct prd *prd;
+  int maxsector;
+
+  if((b = idequeue) == 0)
     panic("idestart");
   if(b->blockno >= FSSIZE)
     panic("incorrect blockno");
   int sector_per_block =  BSIZE/SECTOR_SIZE;
   int sector = b->blockno * sector_per_block;
-  int read_cmd = (sector_per_block == 1) ? IDE_CMD_READ :  IDE_CMD_RDMUL;
-  int write_cmd = (sector_per_block == 1) ? IDE_CMD_WRITE : IDE_CMD_WRMUL;
+  int nsector = sector_per_block;
 
   if (sector_per_block > 7) panic("idestart");
 
+  maxsector = idebm ? IDE_NPRD * sector_per_block : idemult[b->dev&1];
+  for(last = b; last->qnext != 0 && nsector + sector_per_block <= maxsector;
+      last = last->qnext, nsector += sector_per_block){
+    if(last->qnext->dev != b->dev || last->qnext->blockno != last->blockno + 1 ||
+       (last->qnext->flags & B_DIRTY) != (b->flags & B_DIRTY))
+      break;
+  }
+  idenactive = nsector / sector_per_block;
+
+  int read_cmd = (nsector == 1) ? IDE_CMD_READ :  IDE_CMD_RDMUL;
+  int write_cmd = (nsector == 1) ? IDE_CMD_WRITE : IDE_CMD_WRMUL;
+
+  if(idebm){
+    // One descriptor per buf: b->data never crosses a page,
+    // so it never crosses the 64 KB boundary DMA forbids.
+    prd = ideprdt;
+    for(; b != last->qnext; b = b->qnext, prd++){
+      prd->addr = V2P(b->data);
+      prd->count = BSIZE;
+      prd->flags = 0;
+    }
+    prd[-1].flags = PRD_EOT;
+    b = idequeue;
+    outl(idebm + BM_PRDT, V2P(ideprdt));
+    outb(idebm + BM_STATUS, BM_ERR | BM_IRQ);
+    outb(idebm + BM_CMD, (b->flags & B_DIRTY) ? 0 : BM_TOMEM);
+    read_cmd = IDE_CMD_RDDMA;
+    write_cmd = IDE_CMD_WRDMA;
+  }
+
   idewait(0);
   outb(0x3f6, 0);  // generate interrupt
-  outb(0x1f2, sector_per_block);  // number of sectors
+  outb(0x1f2, nsector);  // number of sectors
   outb(0x1f3, sector & 0xff);
   outb(0x1f4, (sector >> 8) & 0xff);
   outb(0x1f5, (sector >> 16) & 0xff);
   outb(0x1f6, 0xe0 | ((b->dev&1)<<4) | ((sector>>24)&0x0f));
   if(b->flags & B_DIRTY){
     outb(0x1f7, write_cmd);
-    outsl(0x1f0, b->data, BSIZE/4);
+    if(!idebm)
+      for(; b != last->qnext; b = b->qnext)
+        outsl(0x1f0, b->data, BSIZE/4);
   } else {
     outb(0x1f7, read_cmd);
   }
+  if(idebm)
+    outb(idebm + BM_CMD, inb(idebm + BM_CMD) | BM_START);
 }
 
 // Interrupt handler.
 void
 ideintr(void)
 {
-  struct buf *b;
+  struct buf *b, *ahead[IDE_NPRD];
+  int i, n, ok, st;
 
-  // First queued buffer is the active request.
+  // The first idenactive queued buffers are the active request.
   acquire(&idelock);
 
   if((b = idequeue) == 0){
     release(&idelock);
     return;
   }
-  idequeue = b->qnext;
+
+  // With DMA the data is in memory already; stop the engine.
+  // A failed transfer left the bufs' data undefined either way.
+  if(idebm){
+    st = inb(idebm + BM_STATUS);
+    if((st & BM_IRQ) == 0){
+      // not ours: the transfer is still running
+      release(&idelock);
+      return;
+    }
+    outb(idebm + BM_CMD, 0);
+    outb(idebm + BM_STATUS, BM_ERR | BM_IRQ);
+    if((st & BM_ERR) || idewait(1) < 0)
+      panic("ideintr: dma error");
+  }
 
   // Read data if needed.
-  if(!(b->flags & B_DIRTY) && idewait(1) >= 0)
-    insl(0x1f0, b->data, BSIZE/4);
+  ok = !(b->flags & B_DIRTY) && idewait(1) >= 0 && !idebm;
 
-  // Wake process waiting for this buf.
-  b->flags |= B_VALID;
-  b->flags &= ~B_DIRTY;
-  wakeup(b);
+  n = 0;
+  for(i = 0; i < idenactive; i++){
+    b = idequeue;
+    idequeue = b->qnext;
+    if(ok)
+      insl(0x1f0, b->data, BSIZE/4);
 
-  // Start disk on next buf in queue.
+    // Wake process waiting for this buf.
+    b->flags |= B_VALID;
+    b->flags &= ~B_DIRTY;
+    wakeup(b);
+    if(b->flags & B_AHEAD)
+      ahead[n++] = b;
+  }
+  idenactive = 0;
+
+  // Start disk on next bufs in queue.
   if(idequeue != 0)
-    idestart(idequeue);
+    idestart();
 
   release(&idelock);
+
+  // No one waits for a read-ahead; hand the buf to the cache.
+  for(i = 0; i < n; i++){
+    ahead[i]->flags &= ~B_AHEAD;
+    breadadone(ahead[i]);
+  }
+}
+
+// Whether a waiting request for b goes before one for c when the
+// disk is at block pos: blocks from pos up first, then the rest
+// from the lowest up (C-LOOK).
+static int
+idebefore(struct buf *b, struct buf *c, uint pos)
+{
+  int bwrap = b->blockno < pos;
+  int cwrap = c->blockno < pos;
+
+  if(bwrap != cwrap)
+    return cwrap;
+  return b->blockno < c->blockno;
+}
+
+// Insert b into idequeue in elevator order and start the disk if it
+// is idle.  Caller must hold idelock.
+static void
+ideappend(struct buf *b)
+{
+  struct buf **pp;
+  uint pos;
+  int i;
+
+  b->qnext = 0;
+  if(idequeue == 0){
+    idequeue = b;
+    idestart();
+    return;
+  }
+
+  // Skip the request in progress; the disk is at its last block.
+  pp = &idequeue;
+  pos = 0;
+  for(i = 0; i < idenactive; i++){
+    pos = (*pp)->blockno + 1;
+    pp = &(*pp)->qnext;
+  }
+  for(; *pp != 0; pp = &(*pp)->qnext)  //DOC:insert-queue
+    if(idebefore(b, *pp, pos))
+      break;
+  b->qnext = *pp;
+  *pp = b;
 }
 
 //PAGEBREAK!
@@ -137,32 +331,57 @@ ideintr(void)
 void
 iderw(struct buf *b)
 {
-  struct buf **pp;
+  iderwv(&b, 1);
+}
 
-  if(!holdingsleep(&b->lock))
-    panic("iderw: buf not locked");
-  if((b->flags & (B_VALID|B_DIRTY)) == B_VALID)
-    panic("iderw: nothing to do");
-  if(b->dev != 0 && !havedisk1)
-    panic("iderw: ide disk 1 not present");
+// Sync n bufs with disk, like iderw. All of them are queued
+// before waiting, so the elevator can sort and merge them.
+void
+iderwv(struct buf **bufs, int n)
+{
+  struct buf *b;
+  int i;
 
-  acquire(&idelock);  //DOC:acquire-lock
+  for(i = 0; i < n; i++){
+    b = bufs[i];
+    if(!holdingsleep(&b->lock))
+      panic("iderw: buf not locked");
+    if((b->flags & (B_VALID|B_DIRTY)) == B_VALID)
+      panic("iderw: nothing to do");
+    if(b->dev != 0 && !havedisk1)
+      panic("iderw: ide disk 1 not present");
+  }
 
-  // Append b to idequeue.
-  b->qnext = 0;
-  for(pp=&idequeue; *pp; pp=&(*pp)->qnext)  //DOC:insert-queue
-    ;
-  *pp = b;
+  acquire(&idelock);  //DOC:acquire-lock
 
-  // Start disk if necessary.
-  if(idequeue == b)
-    idestart(b);
+  for(i = 0; i < n; i++)
+    ideappend(bufs[i]);
 
-  // Wait for request to finish.
-  while((b->flags & (B_VALID|B_DIRTY)) != B_VALID){
-    sleep(b, &idelock);
+  // Wait for requests to finish.
+  for(i = 0; i < n; i++){
+    b = bufs[i];
+    while((b->flags & (B_VALID|B_DIRTY)) != B_VALID){
+      sleep(b, &idelock);
+    }
   }
 
+  release(&idelock);
+}
 
+// Start reading locked buf b from disk and return at once.
+// ideintr releases b with breadadone when the data is in.
+void
+idereadahead(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("idereadahead: buf not locked");
+  if(b->flags & (B_VALID|B_DIRTY))
+    panic("idereadahead: nothing to read");
+  if(b->dev != 0 && !havedisk1)
+    panic("idereadahead: ide disk 1 not present");
+
+  acquire(&idelock);
+  b->flags |= B_AHEAD;
+  ideappend(b);
   release(&idelock);
 }
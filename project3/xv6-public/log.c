@@ -71,16 +71,19 @@ static void
 install_trans(void)
 {
   int tail;
+  struct buf *dbuf[LOGSIZE];
 
   for (tail = 0; tail < log.lh.n; tail++)
   {
     struct buf *lbuf = bread(log.dev, log.start + tail + 1); // read log block
-    struct buf *dbuf = bread(log.dev, log.lh.block[tail]);   // read dst
-    memmove(dbuf->data, lbuf->data, BSIZE);                  // copy block to dst
-    bwrite(dbuf);                                            // write dst to disk
+    dbuf[tail] = bread(log.dev, log.lh.block[tail]);         // read dst
+    memmove(dbuf[tail]->data, lbuf->data, BSIZE);            // copy block to dst
     brelse(lbuf);
-    brelse(dbuf);
   }
+  // write all dst blocks to disk together, in elevator order
+  bwritev(dbuf, log.lh.n);
+  for (tail = 0; tail < log.lh.n; tail++)
+    brelse(dbuf[tail]);
 }
 
 // Read the log header from disk into the in-memory log header
@@ -195,16 +198,19 @@ static void
 write_log(void)
 {
   int tail;
+  struct buf *to[LOGSIZE];
 
   for (tail = 0; tail < log.lh.n; tail++)
   {
-    struct buf *to = bread(log.dev, log.start + tail + 1); // log block
+    to[tail] = bread(log.dev, log.start + tail + 1);        // log block
     struct buf *from = bread(log.dev, log.lh.block[tail]); // cache block
-    memmove(to->data, from->data, BSIZE);
-    bwrite(to); // write the log
+    memmove(to[tail]->data, from->data, BSIZE);
     brelse(from);
-    brelse(to);
   }
+  // the log blocks are consecutive, so they go out in a few large writes
+  bwritev(to, log.lh.n);
+  for (tail = 0; tail < log.lh.n; tail++)
+    brelse(to[tail]);
 }
 
 static void
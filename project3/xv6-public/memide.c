@@ -58,3 +58,20 @@ iderw(struct buf *b)
     memmove(b->data, p, BSIZE);
   b->flags |= B_VALID;
 }
+
+// The memory disk is read at once, so a read-ahead is a plain read.
+void
+idereadahead(struct buf *b)
+{
+  iderw(b);
+  breadadone(b);
+}
+
+void
+iderwv(struct buf **bufs, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    iderw(bufs[i]);
+}
@@ -9,6 +9,9 @@
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
-#define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
+#define NBUF         (MAXOPBLOCKS*3)  // min size of disk block cache
+#define BCACHEFRAC   16  // disk block cache takes 1/BCACHEFRAC of free memory
+#define RAMIN        4  // first read-ahead window of a sequential reader, in blocks
+#define RAMAX        64  // largest read-ahead window, in blocks
 #define FSSIZE       40000  // size of file system in blocks
 
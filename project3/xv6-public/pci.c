@@ -0,0 +1,65 @@
+// PCI configuration space, through configuration mechanism #1
+// (I/O ports 0xCF8 and 0xCFC). Only bus 0 is searched, which is
+// where the devices of the machines xv6 runs on are.
+
+#include "types.h"
+#include "defs.h"
+#include "x86.h"
+#include "pci.h"
+
+#define PCI_CONFADDR  0xCF8
+#define PCI_CONFDATA  0xCFC
+#define PCI_NDEV      32
+#define PCI_NFUNC     8
+
+static uint
+pciconfaddr(int dev, int func, int reg)
+{
+  return 0x80000000 | (dev << 11) | (func << 8) | (reg & 0xfc);
+}
+
+// Read the 32-bit config register reg of device dev, function func.
+uint
+pciconfread(int dev, int func, int reg)
+{
+  outl(PCI_CONFADDR, pciconfaddr(dev, func, reg));
+  return inl(PCI_CONFDATA);
+}
+
+void
+pciconfwrite(int dev, int func, int reg, uint v)
+{
+  outl(PCI_CONFADDR, pciconfaddr(dev, func, reg));
+  outl(PCI_CONFDATA, v);
+}
+
+// Find the first function on bus 0 with the given class and subclass.
+// Store its device and function numbers in *dev and *func.
+// Return 0 on success, -1 if there is none.
+int
+pcifind(int class, int subclass, int *dev, int *func)
+{
+  int d, f;
+  uint id, cls;
+
+  for(d = 0; d < PCI_NDEV; d++){
+    for(f = 0; f < PCI_NFUNC; f++){
+      id = pciconfread(d, f, PCI_ID);
+      if((id & 0xffff) == 0xffff){
+        if(f == 0)
+          break;  // no device
+        continue;
+      }
+      cls = pciconfread(d, f, PCI_CLASS);
+      if((cls >> 24) == class && ((cls >> 16) & 0xff) == subclass){
+        *dev = d;
+        *func = f;
+        return 0;
+      }
+      // only multi-function devices have functions past 0
+      if(f == 0 && (pciconfread(d, f, PCI_HEADER) & 0x800000) == 0)
+        break;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,13 @@
+// PCI configuration space registers.
+
+#define PCI_ID       0x00  // vendor and device id
+#define PCI_COMMAND  0x04  // command and status
+#define PCI_CLASS    0x08  // class, subclass, prog if and revision
+#define PCI_HEADER   0x0c  // header type, bit 23: multi-function
+#define PCI_BAR4     0x20
+
+#define PCI_CMD_IO     0x1  // respond to I/O space accesses
+#define PCI_CMD_MASTER 0x4  // bus master
+
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_IDE  0x01
@@ -7,9 +7,13 @@
 #include "proc.h"
 #include "spinlock.h"
 
+#define SLEEPQBITS 6
+#define NSLEEPQ (1 << SLEEPQBITS)  // sleep queues, sleepers hashed by chan
+
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct proc *sleepq[NSLEEPQ];
 } ptable;
 
 static struct proc *initproc;
@@ -412,6 +416,41 @@ forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// Sleep queue of the processes sleeping on chan.
+static uint
+sleephash(void *chan)
+{
+  return ((uint)chan * 2654435761U) >> (32 - SLEEPQBITS);
+}
+
+// Link p, which is going to sleep on p->chan, into its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqadd(struct proc *p)
+{
+  struct proc **pp;
+
+  pp = &ptable.sleepq[sleephash(p->chan)];
+  p->snext = *pp;
+  *pp = p;
+}
+
+// Unlink sleeping p from its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &ptable.sleepq[sleephash(p->chan)]; *pp != 0; pp = &(*pp)->snext){
+    if(*pp == p){
+      *pp = p->snext;
+      p->snext = 0;
+      return;
+    }
+  }
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void
@@ -438,6 +477,7 @@ sleep(void *chan, struct spinlock *lk)
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  sleepqadd(p);
 
   sched();
 
@@ -453,15 +493,22 @@ sleep(void *chan, struct spinlock *lk)
 
 //PAGEBREAK!
 // Wake up all processes sleeping on chan.
+// Only the sleep queue chan hashes to is searched.
 // The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc **pp, *p;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan)
+  pp = &ptable.sleepq[sleephash(chan)];
+  while((p = *pp) != 0){
+    if(p->chan == chan){
+      *pp = p->snext;
+      p->snext = 0;
       p->state = RUNNABLE;
+    } else
+      pp = &p->snext;
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -486,8 +533,10 @@ kill(int pid)
     if(p->pid == pid){
       p->killed = 1;
       // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
+      if(p->state == SLEEPING){
+        sleepqremove(p);
         p->state = RUNNABLE;
+      }
       release(&ptable.lock);
       return 0;
     }
@@ -49,6 +49,7 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  struct proc *snext;          // Next sleeper in the same sleep queue
 };
 
 // Process memory is laid out contiguously, low addresses first:
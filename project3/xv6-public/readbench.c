@@ -0,0 +1,128 @@
+// Read throughput of the buffer cache with several readers.
+// Every reader process reads its own file over and over, so the
+// readers touch disjoint blocks and, with enough cpus, should scale
+// unless they serialize in the buffer cache. The files are read once
+// before timing, so the timed reads are all cache hits.
+//
+// usage: readbench [maxproc]
+// Runs with 1, 2, 4, ... up to maxproc readers (default 8); run
+// with different CPUS to see the scaling.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fs.h"
+#include "fcntl.h"
+
+#define FILEBLOCKS  128  // blocks per file, 64 KB
+#define NPASS       100  // timed reads of the whole file per reader
+
+char buf[BSIZE];
+char name[] = "readbench.0";
+
+int readfile(int i)
+{
+    int fd, n;
+
+    name[sizeof(name) - 2] = '0' + i;
+    if ((fd = open(name, O_RDONLY)) < 0)
+        return -1;
+    for (n = 0; n < FILEBLOCKS; n++)
+    {
+        if (read(fd, buf, sizeof(buf)) != sizeof(buf))
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+int makefile(int i)
+{
+    int fd, n;
+
+    name[sizeof(name) - 2] = '0' + i;
+    if ((fd = open(name, O_CREATE | O_RDWR)) < 0)
+        return -1;
+    for (n = 0; n < FILEBLOCKS; n++)
+    {
+        buf[0] = n;
+        if (write(fd, buf, sizeof(buf)) != sizeof(buf))
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+void reader(int i)
+{
+    int pass;
+
+    for (pass = 0; pass < NPASS; pass++)
+    {
+        if (readfile(i) < 0)
+        {
+            printf(1, "reader %d: read failed\n", i);
+            break;
+        }
+    }
+    exit();
+}
+
+int main(int argc, char *argv[])
+{
+    int maxproc, nproc, i, start, ticks, kb;
+
+    maxproc = argc > 1 ? atoi(argv[1]) : 8;
+    if (maxproc < 1 || maxproc > 10)
+    {
+        printf(2, "usage: readbench [maxproc], maxproc 1..10\n");
+        exit();
+    }
+
+    printf(1, "readbench: %d KB per file, %d passes per reader\n", FILEBLOCKS * BSIZE / 1024, NPASS);
+    for (i = 0; i < maxproc; i++)
+    {
+        if (makefile(i) < 0 || readfile(i) < 0)
+        {
+            printf(2, "readbench: cannot make %s\n", name);
+            exit();
+        }
+    }
+
+    for (nproc = 1; nproc <= maxproc; nproc *= 2)
+    {
+        start = uptime();
+        for (i = 0; i < nproc; i++)
+        {
+            int pid = fork();
+            if (pid < 0)
+            {
+                printf(2, "readbench: fork failed\n");
+                exit();
+            }
+            if (pid == 0)
+                reader(i);
+        }
+        for (i = 0; i < nproc; i++)
+            wait();
+        ticks = uptime() - start;
+        if (ticks == 0)
+            ticks = 1;
+
+        kb = nproc * NPASS * (FILEBLOCKS * BSIZE / 1024);
+        printf(1, "%d readers: %d KB in %d ticks, %d KB/tick\n", nproc, kb, ticks, kb / ticks);
+    }
+
+    for (i = 0; i < maxproc; i++)
+    {
+        name[sizeof(name) - 2] = '0' + i;
+        unlink(name);
+    }
+    exit();
+}
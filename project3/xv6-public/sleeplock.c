@@ -31,6 +31,22 @@ acquiresleep(struct sleeplock *lk)
   release(&lk->lk);
 }
 
+// Take lk if it is free. Return 1 if taken, 0 without waiting if not.
+int
+tryacquiresleep(struct sleeplock *lk)
+{
+  int r;
+
+  acquire(&lk->lk);
+  r = !lk->locked;
+  if (r) {
+    lk->locked = 1;
+    lk->pid = myproc()->pid;
+  }
+  release(&lk->lk);
+  return r;
+}
+
 void
 releasesleep(struct sleeplock *lk)
 {
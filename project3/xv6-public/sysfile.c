@@ -362,6 +362,7 @@ int sys_open(void)
   f->type = FD_INODE;
   f->ip = ip;
   f->off = 0;
+  f->ranext = f->rawin = f->raend = 0;
   f->readable = !(omode & O_WRONLY);
   f->writable = (omode & O_WRONLY) || (omode & O_RDWR);
   return fd;
@@ -558,6 +559,7 @@ int sys_readlink(void)
   f->type = FD_INODE;
   f->ip = ip;
   f->off = 0;
+  f->ranext = f->rawin = f->raend = 0;
   f->readable = 1;
   f->writable = 0;
 